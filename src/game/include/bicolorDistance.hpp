@@ -0,0 +1,158 @@
+/* ================================================================================
+ * Copyright: (C) 2022, SIRRL Social and Intelligent Robotics Research Laboratory, 
+ *     University of Waterloo, All rights reserved.
+ * 
+ * Authors: 
+ *     Austin Kothig <austin.kothig@uwaterloo.ca>
+ * 
+ * CopyPolicy: Released under the terms of the MIT License. 
+ *     See the accompanying LICENSE file for details.
+ * ================================================================================
+ */
+
+#ifndef TOWER_OF_HANOI_BICOLOR_DISTANCE_HPP
+#define TOWER_OF_HANOI_BICOLOR_DISTANCE_HPP
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include <board.hpp>
+
+
+/* ================================================================================
+**  Exact distances of the 3 peg bicolor game, worked out one size at a time
+**  instead of searching the states of the whole board. Whenever a disk of
+**  some size moves, every smaller disk has to be stacked on the third peg,
+**  so the smaller disks only ever travel between such towers, which differ
+**  by their peg and which color is on top of each size. A game is then a
+**  shortest path over the two disks of the largest size and the towers of
+**  the smaller sizes, with the cost of moving a tower worked out the same
+**  way one size lower. Time grows as 4^disks rather than 12^disks, and
+**  memory as 2^disks.
+** ================================================================================ */
+class BicolorDistance {
+
+    private:
+    /* ============================================================================
+    **  Private variables of the bicolor distance.
+    ** ============================================================================ */
+    std::size_t _num_disk; // Number of disks.
+
+    //-- Moves to take a tower of the smallest k sizes to a tower on the same
+    //-- peg [0] or another peg [1], indexed by the sizes whose top color
+    //-- differs between the two.
+    std::vector<std::array<std::vector<ull>, 2>> _tower;
+
+    //-- Moves from a tower of the smallest k sizes to the goal of those sizes,
+    //-- indexed by the peg of the tower times 2^k plus which sizes have black
+    //-- on top.
+    std::vector<std::vector<ull>> _settle;
+
+    //-- Search of one size of a state, over each placement of its two disks
+    //-- times the number of towers of the smaller sizes, plus the tower.
+    struct Level {
+        std::vector<ull>         below; // Moves from the state to each tower of the smaller sizes.
+        std::vector<ull>         dist;  // Moves from the state to each node.
+        std::vector<std::size_t> pred;  // Node each was reached from, or ~0 for the towers below.
+        ull                      reach; // Moves to the goal of the sizes up to this one.
+    };
+
+
+    public:
+    /* ============================================================================
+    **  Main Constructor. Works out the tower costs of every size below disks.
+    **
+    ** @param disks  the number of disks of the board.
+    ** ============================================================================ */
+    BicolorDistance(std::size_t disks=3);
+
+
+    /* ===========================================================================
+    **  Get the number of disks of the board.
+    **
+    ** @return the number of disks.
+    ** =========================================================================== */
+    std::size_t getNumDisks() const;
+
+
+    /* ===========================================================================
+    **  Get the fewest moves to the goal of the smallest sizes of a state, with
+    **  larger disks left where they are. Larger disks are never in the way of
+    **  smaller ones, so this is the distance of the state if they are in place.
+    **
+    ** @param state  a state of a 3 peg bicolor board of getNumDisks() disks.
+    ** @param sizes  the number of smallest sizes, at most getNumDisks().
+    **
+    ** @return the number of moves to put every black of those sizes on peg 0
+    **     and every white on peg 1.
+    ** =========================================================================== */
+    ull getDistance(const BoardSnapshot& state, std::size_t sizes) const;
+
+
+    /* ===========================================================================
+    **  Get the first move of a shortest path to the goal of the smallest
+    **  sizes of a state, with larger disks left where they are.
+    **
+    ** @param state  a state of a 3 peg bicolor board of getNumDisks() disks.
+    ** @param sizes  the number of smallest sizes, at most getNumDisks().
+    ** @param from   where the peg to move from is written.
+    ** @param to     where the peg to move to is written.
+    ** @param [optional] dist  where the moves to the goal are written too.
+    **
+    ** @return false if those sizes are already at their goal.
+    ** =========================================================================== */
+    bool getBestMove(const BoardSnapshot& state, std::size_t sizes, int& from, int& to,
+                     ull* dist=nullptr) const;
+
+
+    private:
+    /* ===========================================================================
+    **  Search each size of a state in turn, from the smallest.
+    **
+    ** @param state   a state of a 3 peg bicolor board.
+    ** @param sizes   the number of smallest sizes.
+    ** @param levels  where the search of each size is written, from index 1,
+    **     with an empty level 0 below the smallest.
+    **
+    ** @return the moves to the goal of those sizes.
+    ** =========================================================================== */
+    ull searchState(const BoardSnapshot& state, std::size_t sizes, std::vector<Level>& levels) const;
+
+
+    /* ===========================================================================
+    **  Find the fewest moves from a start to every placement of the two disks
+    **  of a size along with a tower of the smaller sizes.
+    **
+    ** @param size   the size of the pair.
+    ** @param pair   the start placement of the pair (see getPair).
+    ** @param level  holds the moves from the start to each tower of the
+    **     smaller sizes, and is where the search is written.
+    ** =========================================================================== */
+    void searchLevel(std::size_t size, std::size_t pair, Level& level) const;
+
+
+    /* ===========================================================================
+    **  Read the moves to each tower of a size and all those below it, out of
+    **  the result of searchLevel.
+    **
+    ** @param size      the size searched.
+    ** @param dist      the result of searchLevel.
+    ** @param gathered  where the moves to each tower are written.
+    ** =========================================================================== */
+    static void collect(std::size_t size, const std::vector<ull>& dist, std::vector<ull>& gathered);
+
+
+    /* ===========================================================================
+    **  Get the placement of the two disks of a size, numbered black peg times
+    **  3 plus white peg, except 9 plus the peg when white is on top of black.
+    **
+    ** @param state  a state of a 3 peg bicolor board.
+    ** @param size   the size of the disks, from 1 for the smallest.
+    **
+    ** @return a placement in [0, 12).
+    ** =========================================================================== */
+    static std::size_t getPair(const BoardSnapshot& state, std::size_t size);
+};
+
+#endif /* TOWER_OF_HANOI_BICOLOR_DISTANCE_HPP */
@@ -13,12 +13,17 @@
 #ifndef TOWER_OF_HANOI_BOARD_HPP
 #define TOWER_OF_HANOI_BOARD_HPP
 
+#include <array>
+#include <cstdint>
 #include <iostream>
 #include <memory>
 #include <sstream>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
+#include <hash.hpp>
+
 
 typedef unsigned long long ull;
 
@@ -29,11 +34,11 @@ class Disk {
 
     public:
     Disk(int s, int c=0) : size(s), color(c) {}
-    int  getSize()  { return size;  }
-    int  getColor() { return color; }
-    bool operator>(const Disk& lhs)  { return this->size >  lhs.size; }
-    bool operator==(const Disk& lhs) { return this->size == lhs.size; }
-    bool operator==(const int lhs)   { return this->size == lhs;      }
+    int  getSize()  const { return size;  }
+    int  getColor() const { return color; }
+    bool operator>(const Disk& lhs)  const { return this->size >  lhs.size; }
+    bool operator==(const Disk& lhs) const { return this->size == lhs.size; }
+    bool operator==(const int lhs)   const { return this->size == lhs;      }
     friend std::ostream& operator<<(std::ostream& os, const Disk& dsk) { 
         os << "(" << (dsk.color ? "W1" : "B0") << ":" << dsk.size << ")"; 
         return os; 
@@ -41,6 +46,25 @@ class Disk {
 };
 
 
+/* ================================================================================
+**  Compact copy of a board state that can be passed around by value. Holds
+**  the same peg bitplanes as the Board it was taken from, for up to MAX_PEGS
+**  pegs, along with the tracked hash and misplaced disk count.
+** ================================================================================ */
+struct BoardSnapshot {
+    static constexpr std::size_t MAX_PEGS = 8;
+
+    std::array<std::uint64_t, MAX_PEGS> blacks;
+    std::array<std::uint64_t, MAX_PEGS> whites;
+    std::array<std::uint64_t, MAX_PEGS> order;
+    hash_t                              hash;
+    std::size_t                         misplaced;
+
+    hash_t getHashableState() const { return hash; }
+    bool   isGoal()           const { return misplaced == 0; }
+};
+
+
 class Board {
 
     private:
@@ -55,6 +79,38 @@ class Board {
     std::vector<std::vector<Disk>> _state; // Board state.
     std::vector<std::vector<Disk>> _goal;  // Goal state.
 
+    //-- Each peg is kept as bitplanes, where bit (size-1) is set if the
+    //-- disk of that size and color is on the peg. The top disk is therefore
+    //-- the lowest set bit of both colors. Mono disks are all black. When a
+    //-- peg holds both disks of a size, `_order` tells if black is on top.
+    //-- `_state` is only rebuilt from the planes when the raw state is requested.
+    std::vector<std::uint64_t> _blacks;
+    std::vector<std::uint64_t> _whites;
+    std::vector<std::uint64_t> _order;
+    bool                       _state_stale;
+
+    //-- The hash of the current state is kept up to date by every move,
+    //-- along with how many disks are not on their goal peg.
+    std::vector<hash_t> _powers;    // Place value of each encoding slot.
+    hash_t              _hash;      // Hash of the current state.
+    hash_t              _goal_hash; // Hash of the goal state.
+    std::size_t         _misplaced; // Number of disks not on their goal peg.
+
+    std::vector<std::size_t> _encoding; // Scratch space reused when encoding or decoding.
+    std::vector<std::size_t> _symmetry; // Scratch space reused when canonicalizing.
+
+    //-- Rendering writes prebuilt row pieces into one reused buffer. There is
+    //-- a glyph per disk size and color (size 0 being a bare peg), and the
+    //-- rendered text of recent states is kept by hash.
+    static constexpr std::size_t RENDER_CACHE_LIMIT = 1024;
+
+    std::vector<std::string>                          _glyphs;
+    std::string                                       _base_row;
+    std::string                                       _label_row;
+    std::string                                       _render;
+    std::string                                       _goal_render;
+    std::unordered_map<hash_t,std::string,HashHasher> _render_cache;
+
 
 
     public:
@@ -112,7 +168,7 @@ class Board {
     **
     ** @return success of if the given hash was accepted. If false, board state is unchanged.
     ** =========================================================================== */
-    bool setFromHashableState(ull hash);
+    bool setFromHashableState(hash_t hash);
 
 
     /* ===========================================================================
@@ -155,6 +211,16 @@ class Board {
     std::vector<std::vector<Disk>> getRawGoal();
 
 
+    /* ===========================================================================
+    **  Get a read-only view of the raw state or goal state of the game board.
+    **  The view is only valid until the board is next changed.
+    **
+    ** @return a reference to the 2D vector holding the raw board state.
+    ** =========================================================================== */
+    const std::vector<std::vector<Disk>>& viewRawState();
+    const std::vector<std::vector<Disk>>& viewRawGoal();
+
+
     /* ===========================================================================
     **  Get a showable state of the board state or goal state.
     **
@@ -169,8 +235,109 @@ class Board {
     **
     ** @return a hash that can be passed to a solving interface.
     ** =========================================================================== */
-    ull getHashableState();
-    ull getHashableGoal();
+    hash_t getHashableState();
+    hash_t getHashableGoal();
+
+
+    /* ===========================================================================
+    **  Set the game board state from its rank. Every valid state has a rank
+    **  in [0, getNumStates()), so ranks can index plain arrays.
+    **
+    ** @param rank  The dense index of the desired board state.
+    **
+    ** @return success of if the given rank was accepted. If false, board state is unchanged.
+    ** =========================================================================== */
+    bool setFromRankedState(hash_t rank);
+
+
+    /* ===========================================================================
+    **  Get the rank of the current board state, or of a snapshot.
+    **
+    ** @param [optional] snapshot  the state to rank instead of the board.
+    **
+    ** @return a dense index in [0, getNumStates()).
+    ** =========================================================================== */
+    hash_t getRankedState();
+    hash_t getRankedState(const BoardSnapshot& snapshot);
+
+
+    /* ===========================================================================
+    **  Write the state of a rank into a snapshot, without going through its hash.
+    **
+    ** @param rank      The dense index of the desired board state.
+    ** @param snapshot  where the state is written.
+    **
+    ** @return false if the rank is out of range, or the board is not set or 
+    **     too wide for a snapshot. The snapshot is unchanged if false.
+    ** =========================================================================== */
+    bool getSnapshotFromRank(hash_t rank, BoardSnapshot& snapshot);
+
+
+    /* ===========================================================================
+    **  Get the number of valid board states, which bounds every rank.
+    **  This is pegs^disks for mono and (pegs^2 + pegs)^disks for bicolor.
+    **
+    ** @return the count of distinct board states.
+    ** =========================================================================== */
+    hash_t getNumStates();
+
+
+    /* ===========================================================================
+    **  Convert between the dense rank and the sparse hash of a board state.
+    **
+    ** @param rank  a dense index in [0, getNumStates()).
+    ** @param hash  a unique hash for a board state.
+    **
+    ** @return the hash of the ranked state, or the rank of the hashed state. 
+    **     hashToRank returns getNumStates() if the hash is not a valid state.
+    ** =========================================================================== */
+    hash_t rankToHash(hash_t rank);
+    hash_t hashToRank(hash_t hash);
+
+
+    /* ===========================================================================
+    **  Check if the board is currently in the goal state.
+    **
+    ** @return true if every disk is on its goal peg.
+    ** =========================================================================== */
+    bool isGoal();
+
+
+    /* ===========================================================================
+    **  Get the number of disks that are not on their goal peg.
+    **
+    ** @return the count of out of place disks, zero at the goal state.
+    ** =========================================================================== */
+    std::size_t getNumMisplaced();
+
+
+    /* ===========================================================================
+    **  Get a lower bound on the number of moves from the current state, or from
+    **  a snapshot, to the goal. Every disk off its goal peg has to move once, 
+    **  and twice if it first has to get out of the way of a larger disk. With 
+    **  3 mono pegs the classic recursion gives the exact distance instead.
+    **
+    ** @param [optional] snapshot  the state to bound instead of the board.
+    **
+    ** @return an admissible estimate of the distance to the goal.
+    ** =========================================================================== */
+    ull getLowerBound();
+    ull getLowerBound(const BoardSnapshot& snapshot);
+
+
+    /* ===========================================================================
+    **  Get the optimal move of a classic 3 peg mono board in closed form. 
+    **  Going from the largest disk down, each disk off its target sends the
+    **  smaller disks to the third peg, and the smallest disk off its target
+    **  is the one to move. Pairs with getLowerBound, which is exact here.
+    **
+    ** @param from  where the peg to move from is written.
+    ** @param to    where the peg to move to is written.
+    **
+    ** @return false if the board is not a set 3 peg mono board, or is already
+    **     at the goal. Nothing is written if false.
+    ** =========================================================================== */
+    bool getClassicMove(int& from, int& to);
 
 
     /* ===========================================================================
@@ -180,19 +347,35 @@ class Board {
     **
     ** @return a unique hash for the vector.
     ** =========================================================================== */
-    ull computeHash(std::vector<std::size_t> encoding);
+    hash_t computeHash(const std::vector<std::size_t>& encoding);
 
 
     /* ===========================================================================
     **  Compute the corresponding vector repersenting the game board from an input hash.
     **  If no hash is provided, will generate the encoding from the board's raw state.
     **
-    ** @param [optional] hash  a unique hash for a board state.
+    ** @param [optional] hash      a unique hash for a board state.
+    ** @param [optional] encoding  a vector to write the encoding into, 
+    **     which avoids allocating when its capacity is already large enough.
     **
     ** @return an encoding representing the state of the game board.
     ** =========================================================================== */
-    std::vector<std::size_t> generateEncoding(const std::vector<std::vector<Disk>> board);
-    std::vector<std::size_t> generateEncoding(ull hash);
+    std::vector<std::size_t> generateEncoding(const std::vector<std::vector<Disk>>& board);
+    std::vector<std::size_t> generateEncoding(hash_t hash);
+    void generateEncoding(const std::vector<std::vector<Disk>>& board, std::vector<std::size_t>& encoding);
+    void generateEncoding(hash_t hash, std::vector<std::size_t>& encoding);
+
+
+    /* ===========================================================================
+    **  Batched computeHash and generateEncoding over many states at once, 
+    **  vectorized where the machine allows it (see hashBatch.hpp).
+    **
+    ** @param encodings  the encodings of each state one after another, 
+    **     pegs*disks digits each.
+    ** @param hashes     a unique hash for each board state.
+    ** =========================================================================== */
+    void computeHashes(const std::vector<std::size_t>& encodings, std::vector<hash_t>& hashes);
+    void generateEncodings(const std::vector<hash_t>& hashes, std::vector<std::size_t>& encodings);
 
 
     /* ===========================================================================
@@ -206,6 +389,79 @@ class Board {
     bool move(const int from, const int to);
 
 
+    /* ===========================================================================
+    **  Type of a saved board state, so search code can treat boards alike.
+    ** =========================================================================== */
+    typedef BoardSnapshot Snapshot;
+
+
+    /* ===========================================================================
+    **  Save the current state into a snapshot, or restore it from one.
+    **
+    ** @param snapshot  the snapshot to write into or read from.
+    **
+    ** @return false if the board is not set, or has more than 
+    **     BoardSnapshot::MAX_PEGS pegs. Nothing is changed if false.
+    ** =========================================================================== */
+    bool saveSnapshot(BoardSnapshot& snapshot);
+    bool loadSnapshot(const BoardSnapshot& snapshot);
+
+
+    /* ===========================================================================
+    **  Make a move on a snapshot without changing the board. The snapshot has
+    **  to come from a board with the same settings.
+    **
+    ** @param snapshot  the state to move from.
+    ** @param from      The source peg.
+    ** @param to        The target peg.
+    ** @param next      where the successor state is written. Holds an unchanged 
+    **     copy of snapshot if the move was not legal.
+    **
+    ** @return true if the move was legal and made.
+    ** =========================================================================== */
+    bool applyMove(const BoardSnapshot& snapshot, const int from, const int to, BoardSnapshot& next);
+
+
+    /* ===========================================================================
+    **  Get the legal moves of the current state, or of a snapshot, as a mask.
+    **  A move (from, to) is bit getMoveIndex(from, to), which numbers every pair
+    **  of distinct pegs in order. Only boards that fit a snapshot have masks.
+    **
+    ** @param [optional] snapshot  the state to find the moves of instead of the board.
+    **
+    ** @return the mask of legal moves, 0 if the board is not set or too wide.
+    ** =========================================================================== */
+    std::uint64_t getLegalMoves();
+    std::uint64_t getLegalMoves(const BoardSnapshot& snapshot);
+
+
+    /* ===========================================================================
+    **  Convert between a move and its bit in a mask of legal moves.
+    **
+    ** @param from   The source peg.
+    ** @param to     The target peg.
+    ** @param index  the bit of the move, from*(pegs-1) + (to < from ? to : to-1).
+    ** =========================================================================== */
+    std::size_t getMoveIndex(const int from, const int to);
+    void        getMoveFromIndex(std::size_t index, int& from, int& to);
+
+
+    /* ===========================================================================
+    **  Get the canonical representative of the current state, or of a snapshot,
+    **  among all states that are the same distance from the goal by symmetry.
+    **  In mono every peg but the goal peg can be relabeled. In bicolor pegs 2 
+    **  and up can be relabeled, and the colors can be swapped along with pegs 0 and 1.
+    **
+    ** @param [optional] snapshot  the state to canonicalize instead of the board.
+    ** @param pegs  written with the board peg of each peg of the canonical state,
+    **     so a move (from, to) on the canonical state is (pegs[from], pegs[to]) here.
+    **
+    ** @return the hash of the canonical state.
+    ** =========================================================================== */
+    hash_t getCanonicalState(std::vector<std::size_t>& pegs);
+    hash_t getCanonicalState(const BoardSnapshot& snapshot, std::vector<std::size_t>& pegs);
+
+
     private:
     /* ===========================================================================
     **  Allocate fresh storage space for the board.
@@ -213,14 +469,102 @@ class Board {
     void allocateNewBoard();
 
 
+    /* ===========================================================================
+    **  Rebuild the raw board state from the peg bitplanes.
+    **  Does nothing if the raw state is up to date.
+    ** =========================================================================== */
+    void syncRawState();
+
+
+    /* ===========================================================================
+    **  Recompute the place value of each encoding slot for the current settings.
+    ** =========================================================================== */
+    void updatePowers();
+
+
+    /* ===========================================================================
+    **  Recompute the hash and misplaced disk count from scratch. Used whenever
+    **  the whole state is replaced rather than changed by a single move.
+    ** =========================================================================== */
+    void refreshTracking();
+
+
+    /* ===========================================================================
+    **  Compute the hash and misplaced disk count of the given bitplanes.
+    ** =========================================================================== */
+    template<typename Planes>
+    void trackPlanes(const Planes& blacks, const Planes& whites, const Planes& order, 
+                     hash_t& hash, std::size_t& misplaced);
+
+
+    /* ===========================================================================
+    **  Bound the distance of the given bitplanes to the goal (see getLowerBound).
+    ** =========================================================================== */
+    template<typename Planes>
+    ull boundPlanes(const Planes& blacks, const Planes& whites, const Planes& order);
+
+
+    /* ===========================================================================
+    **  Compute the rank of the given bitplanes (see getRankedState).
+    ** =========================================================================== */
+    template<typename Planes>
+    hash_t rankPlanes(const Planes& blacks, const Planes& whites, const Planes& order);
+
+
+    /* ===========================================================================
+    **  Check if every state of the current settings has a hash that fits in hash_t.
+    ** =========================================================================== */
+    bool hashFits();
+
+
+    /* ===========================================================================
+    **  Find the legal moves of the given bitplanes (see getLegalMoves).
+    ** =========================================================================== */
+    template<typename Planes>
+    std::uint64_t legalPlanes(const Planes& blacks, const Planes& whites);
+
+
+    /* ===========================================================================
+    **  Canonicalize the given bitplanes (see getCanonicalState).
+    ** =========================================================================== */
+    template<typename Planes>
+    hash_t canonicalPlanes(const Planes& blacks, const Planes& whites, const Planes& order, 
+                           std::vector<std::size_t>& pegs);
+
+
+    /* ===========================================================================
+    **  Compute the hash of the given bitplanes with the pegs relabeled.
+    **
+    ** @param blacks, whites, order  the peg bitplanes to read.
+    ** @param pegs     the plane peg to use for each peg of the hash.
+    ** @param swapped  whether to swap the colors of every disk.
+    ** =========================================================================== */
+    template<typename Planes>
+    hash_t hashPlanes(const Planes& blacks, const Planes& whites, const Planes& order, 
+                      const std::vector<std::size_t>& pegs, bool swapped);
+
+
+    /* ===========================================================================
+    **  Get the peg a disk of the given color has to end up on.
+    ** =========================================================================== */
+    std::size_t goalPeg(std::size_t color);
+
+
+    /* ===========================================================================
+    **  Build the glyphs and fixed rows used to draw boards of the current
+    **  settings, and forget every rendered state.
+    ** =========================================================================== */
+    void updateGlyphs();
+
+
     /* ===========================================================================
     **  Draw a nicely formatted board.
     ** 
     ** @param board  Desired game board to draw (current/goal state).
-    **
-    ** @return A UTF-8 string to pass to be displayed.
+    ** @param out    where the UTF-8 string to be displayed is written. 
+    **     Its capacity is reused between calls.
     ** =========================================================================== */
-    std::string drawBoard(const std::vector<std::vector<Disk>> board);
+    void drawBoard(const std::vector<std::vector<Disk>>& board, std::string& out);
 
 
     /* ===========================================================================
@@ -0,0 +1,139 @@
+/* ================================================================================
+ * Copyright: (C) 2022, SIRRL Social and Intelligent Robotics Research Laboratory, 
+ *     University of Waterloo, All rights reserved.
+ * 
+ * Authors: 
+ *     Austin Kothig <austin.kothig@uwaterloo.ca>
+ * 
+ * CopyPolicy: Released under the terms of the MIT License. 
+ *     See the accompanying LICENSE file for details.
+ * ================================================================================
+ */
+
+#ifndef TOWER_OF_HANOI_BOARD_PLANES_HPP
+#define TOWER_OF_HANOI_BOARD_PLANES_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include <hash.hpp>
+
+
+/* ================================================================================
+**  Move rules on peg bitplanes, shared by Board, its snapshots and FixedBoard
+**  so they are only written once. Bit (size-1) of a plane is set when the
+**  disk of that size and color is on the peg, and `order` marks a same size
+**  pair with black on top. Mono disks are all black.
+** ================================================================================ */
+
+
+/* ================================================================================
+**  Get the encoding digit of a single slot (see Board::generateEncoding).
+**
+** @param blacks, whites, order  the peg bitplanes to read.
+** @param peg   the peg of the slot.
+** @param disk  the plane bit of the disk size of the slot.
+**
+** @return 0 if empty, 1 black, 2 white, 3 a pair with white on top and 4 a
+**     pair with black on top.
+** ================================================================================ */
+template<typename Planes>
+inline hash_t planesSlotDigit(const Planes& blacks, const Planes& whites, const Planes& order,
+                              std::size_t peg, std::uint64_t disk) {
+
+    bool black = blacks[peg] & disk;
+    bool white = whites[peg] & disk;
+
+    if (black && white) { return (order[peg] & disk) ? 4 : 3; }
+    return ( black ? 1 : (white ? 2 : 0) );
+}
+
+
+/* ================================================================================
+**  Move the top disk of one peg to another on the given bitplanes, keeping
+**  the hash and misplaced count up to date.
+**
+** @param blacks, whites, order  the peg bitplanes to change.
+** @param hash       the hash of the planes.
+** @param misplaced  the number of misplaced disks of the planes.
+** @param pegs       the number of pegs.
+** @param disks      the number of disks.
+** @param bicolor    whether the board is bicolor.
+** @param powers     the place value of each slot of the hash.
+** @param from       The source peg.
+** @param to         The target peg.
+**
+** @return true if the move was legal and made.
+** ================================================================================ */
+template<typename Planes, typename Powers>
+inline bool planesMove(Planes& blacks, Planes& whites, Planes& order, hash_t& hash, std::size_t& misplaced,
+                       std::size_t pegs, std::size_t disks, bool bicolor, const Powers& powers,
+                       const int from, const int to) {
+
+    //-- Check if to and from are within range of our pegs.
+    if (from < 0 || (std::size_t)from >= pegs) { return false; }
+    if (to   < 0 || (std::size_t)to   >= pegs) { return false; }
+
+    //-- Check if the from position has a disk to take.
+    std::uint64_t src = blacks[from] | whites[from];
+    if (src == 0) { return false; }
+
+    //-- The top disk is the lowest set bit. It can only go onto a peg
+    //-- that holds no smaller disk (a same size disk is fine in bicolor).
+    std::uint64_t disk = src & (~src + 1);
+    if ((blacks[to] | whites[to]) & (disk - 1)) { return false; }
+
+    //-- Moving a disk onto its own peg changes nothing.
+    if (from == to) { return true; }
+
+    std::size_t ddx = disks - __builtin_ctzll(disk) - 1;
+    hash_t from_power = powers[ddx + (from * disks)];
+    hash_t to_power   = powers[ddx + (to   * disks)];
+
+    //-- Mono slots only ever hold a single black disk, headed for the last peg.
+    if (!bicolor) {
+        blacks[from] ^= disk;
+        blacks[to]   |= disk;
+
+        hash -= from_power;
+        hash += to_power;
+
+        if ((std::size_t)from == pegs-1) { misplaced += 1; }
+        if ((std::size_t)to   == pegs-1) { misplaced -= 1; }
+
+        return true;
+    }
+
+    //-- Find the color of the top disk. For a same size pair, the order
+    //-- bit says which of the two is on top.
+    std::size_t color;
+    if (blacks[from] & whites[from] & disk) {
+        color = (order[from] & disk) ? 0 : 1;
+    } else {
+        color = (blacks[from] & disk) ? 0 : 1;
+    }
+
+    //-- Take the old digits of both slots out of the hash.
+    hash -= planesSlotDigit(blacks, whites, order, from, disk) * from_power;
+    hash -= planesSlotDigit(blacks, whites, order, to,   disk) * to_power;
+
+    //-- Else everything is okay, make the move. Landing on the other
+    //-- color of the same size makes a pair with this disk on top.
+    Planes& plane = ( color ? whites : blacks );
+    plane[from] ^= disk;
+    plane[to]   |= disk;
+    order[from] &= ~disk;
+    if (color == 0 && (whites[to] & disk)) { order[to] |= disk; }
+
+    //-- Put the new digits of both slots into the hash.
+    hash += planesSlotDigit(blacks, whites, order, from, disk) * from_power;
+    hash += planesSlotDigit(blacks, whites, order, to,   disk) * to_power;
+
+    //-- Black goes to peg 0 and white to peg 1.
+    if ((std::size_t)from == color) { misplaced += 1; }
+    if ((std::size_t)to   == color) { misplaced -= 1; }
+
+    return true;
+}
+
+#endif /* TOWER_OF_HANOI_BOARD_PLANES_HPP */
@@ -0,0 +1,115 @@
+/* ================================================================================
+ * Copyright: (C) 2022, SIRRL Social and Intelligent Robotics Research Laboratory, 
+ *     University of Waterloo, All rights reserved.
+ * 
+ * Authors: 
+ *     Austin Kothig <austin.kothig@uwaterloo.ca>
+ * 
+ * CopyPolicy: Released under the terms of the MIT License. 
+ *     See the accompanying LICENSE file for details.
+ * ================================================================================
+ */
+
+#ifndef TOWER_OF_HANOI_DISK_TABLE_HPP
+#define TOWER_OF_HANOI_DISK_TABLE_HPP
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <board.hpp>
+
+
+/* ================================================================================
+**  Distance table kept on disk, for boards whose states do not fit in memory.
+**  The breadth-first search from the goal writes each layer as a file of
+**  sorted ranks. Successors are gathered into sorted run files of at most
+**  a buffer's worth of states, then merged into the next layer, dropping
+**  states of the previous two layers. Moves can be undone, so no successor
+**  lies further back. Finished layers are written out to one file of
+**  distances indexed by rank, which queries then read from.
+** ================================================================================ */
+class DiskTable {
+
+    private:
+    /* ============================================================================
+    **  Private variables of the disk table.
+    ** ============================================================================ */
+    std::string   _directory; // Where the table and search files are kept.
+    std::string   _name;      // Prefix of every file, from the board settings.
+    std::size_t   _buffer;    // Most states held in memory at once.
+    hash_t        _states;    // Number of ranks in the table.
+    hash_t        _reached;   // Number of ranks with a distance.
+    std::ifstream _table;     // The table file, once built.
+
+
+    public:
+    /* ============================================================================
+    **  Main Constructor.
+    **
+    ** @param directory  where the table and search files are written.
+    ** @param buffer     the most states held in memory at once, at least 1.
+    ** ============================================================================ */
+    DiskTable(const std::string& directory=".", std::size_t buffer=1<<22);
+
+
+    /* ===========================================================================
+    **  Destructor. Keeps the table file.
+    ** =========================================================================== */
+    ~DiskTable();
+
+
+    /* ===========================================================================
+    **  Search every state of the board, and write the table file.
+    **
+    ** @param board  a board with the settings to search, which fits a snapshot.
+    **
+    ** @return false if a file could not be written, or the board is not set.
+    ** =========================================================================== */
+    bool build(Board& board);
+
+
+    /* ===========================================================================
+    **  Read the distance of a rank from the table file.
+    **
+    ** @param rank  a dense index of a board state.
+    ** @param dist  where the distance is written.
+    **
+    ** @return false if the table is not built, or the rank was never reached.
+    ** =========================================================================== */
+    bool lookup(hash_t rank, ull& dist);
+
+
+    /* ===========================================================================
+    **  Get the number of ranks in the table, and of those reached.
+    **
+    ** @return a count of board states.
+    ** =========================================================================== */
+    hash_t getNumStates();
+    hash_t getNumReached();
+
+
+    /* ===========================================================================
+    **  Get the path of the table file, which holds a 32 bit distance for each
+    **  rank in the machine's byte order, UINT32_MAX if unreached.
+    **
+    ** @return the path of the table file.
+    ** =========================================================================== */
+    std::string getTablePath();
+
+
+    private:
+    /* ===========================================================================
+    **  Get the path of a search file, which is named after the process so
+    **  builds of the same board in one directory do not clash.
+    **
+    ** @param kind   what the file holds.
+    ** @param index  which file of that kind.
+    **
+    ** @return the path of the file.
+    ** =========================================================================== */
+    std::string getPath(const std::string& kind, std::size_t index);
+};
+
+#endif /* TOWER_OF_HANOI_DISK_TABLE_HPP */
@@ -0,0 +1,357 @@
+/* ================================================================================
+ * Copyright: (C) 2022, SIRRL Social and Intelligent Robotics Research Laboratory, 
+ *     University of Waterloo, All rights reserved.
+ * 
+ * Authors: 
+ *     Austin Kothig <austin.kothig@uwaterloo.ca>
+ * 
+ * CopyPolicy: Released under the terms of the MIT License. 
+ *     See the accompanying LICENSE file for details.
+ * ================================================================================
+ */
+
+#ifndef TOWER_OF_HANOI_FIXEDBOARD_HPP
+#define TOWER_OF_HANOI_FIXEDBOARD_HPP
+
+#include <array>
+#include <cstdint>
+#include <utility>
+
+#include <boardPlanes.hpp>
+#include <hash.hpp>
+
+
+/* ================================================================================
+**  Range of pegs and disks that get a compile time FixedBoard instantiation.
+**  Settings outside of this range fall back to the runtime Board.
+** ================================================================================ */
+const std::size_t FIXED_BOARD_MIN = 3;
+const std::size_t FIXED_BOARD_MAX = 6;
+
+
+/* ================================================================================
+**  Compile time helpers for building the tables of a FixedBoard.
+** ================================================================================ */
+template<std::size_t Slots>
+constexpr std::array<hash_t, Slots> fixedBoardPowers(hash_t radix) {
+    std::array<hash_t, Slots> powers{};
+    hash_t power = 1;
+    for (std::size_t edx = 0; edx < Slots; ++edx) {
+        powers[edx] = power;
+        power *= radix;
+    }
+    return powers;
+}
+
+constexpr bool fixedBoardFits(std::size_t slots, hash_t radix) {
+    //-- Largest hash is radix^slots - 1, stop if any slot would overflow.
+    const hash_t limit = ~((hash_t)0);
+    hash_t largest = 0;
+    for (std::size_t edx = 0; edx < slots; ++edx) {
+        if (largest > (limit - (radix - 1)) / radix) { return false; }
+        largest = (largest * radix) + (radix - 1);
+    }
+    return true;
+}
+
+template<std::size_t Pegs, std::size_t Disks, bool Bicolor, std::size_t Slots>
+constexpr hash_t fixedBoardGoal(const std::array<hash_t, Slots>& powers) {
+    //-- Mono: every disk on the last peg. Bicolor: black on 0 and white on 1.
+    hash_t goal = 0;
+    for (std::size_t ddx = 0; ddx < Disks; ++ddx) {
+        if (Bicolor) {
+            goal += 1 * powers[ddx];
+            goal += 2 * powers[ddx + Disks];
+        } else {
+            goal += powers[ddx + ((Pegs-1) * Disks)];
+        }
+    }
+    return goal;
+}
+
+
+/* ================================================================================
+**  Board whose settings are known at compile time. Keeps the same hash,
+**  move rules (see boardPlanes.hpp) and tracking as Board, but with fixed
+**  size storage and constant tables, for use in hot search loops.
+** ================================================================================ */
+template<std::size_t Pegs, std::size_t Disks, bool Bicolor>
+class FixedBoard {
+
+    public:
+    /* ============================================================================
+    **  Compile time constants of the board.
+    ** ============================================================================ */
+    static constexpr std::size_t NUM_SLOTS = Pegs * Disks;                    // Encoding slots.
+    static constexpr hash_t      RADIX     = Bicolor ? 5 : 2;                 // States per slot.
+    static constexpr bool        FITS      = fixedBoardFits(NUM_SLOTS, RADIX); // Hashes fit a hash_t.
+
+    static constexpr std::array<hash_t, NUM_SLOTS> POWERS = fixedBoardPowers<NUM_SLOTS>(RADIX);
+    static constexpr hash_t GOAL = fixedBoardGoal<Pegs, Disks, Bicolor>(POWERS);
+
+
+    private:
+    /* ============================================================================
+    **  Private variables of the board.
+    **
+    **  Same bitplanes as Board: bit (size-1) is set when the disk of that size
+    **  and color is on the peg, and `_order` marks a same size pair with black
+    **  on top. Mono disks are all black.
+    ** ============================================================================ */
+    std::array<std::uint64_t, Pegs> _blacks;
+    std::array<std::uint64_t, Pegs> _whites;
+    std::array<std::uint64_t, Pegs> _order;
+
+    hash_t      _hash;      // Hash of the current state.
+    std::size_t _misplaced; // Number of disks not on their goal peg.
+
+
+    public:
+    /* ============================================================================
+    **  Main Constructor.
+    ** ============================================================================ */
+    FixedBoard() : _blacks{}, _whites{}, _order{}, _hash(0), _misplaced(0) {}
+
+
+    /* ===========================================================================
+    **  Get the settings of the board.
+    ** =========================================================================== */
+    static constexpr std::size_t getNumPegs()    { return Pegs;    }
+    static constexpr std::size_t getNumDisks()   { return Disks;   }
+    static constexpr bool        getIsBicolor()  { return Bicolor; }
+
+
+    /* ===========================================================================
+    **  Initialize the board state to the default start state.
+    **
+    ** @return success of initializing the board.
+    ** =========================================================================== */
+    bool init() {
+
+        _blacks = {};
+        _whites = {};
+        _order  = {};
+
+        if (Bicolor) {
+            for (std::size_t size = 0; size < Disks; ++size) {
+                std::uint64_t disk = 1ULL << (Disks - size - 1);
+                ((size+1) % 2 ? _whites : _blacks)[0] |= disk;
+                ((size+2) % 2 ? _whites : _blacks)[1] |= disk;
+            }
+        } else {
+            _blacks[0] = (~0ULL >> (64 - Disks));
+        }
+
+        this->refreshTracking();
+        return true;
+    }
+
+
+    /* ===========================================================================
+    **  Set the game board state from a unique descriptor.
+    **
+    ** @param hash  The unique descriptor for the desired board state.
+    **
+    ** @return success of if the given hash was accepted. If false, board state is unchanged.
+    ** =========================================================================== */
+    bool setFromHashableState(hash_t hash) {
+
+        //-- Set each digit's disks on the planes of a copy, and check that
+        //-- every size ends up with one black (and one white if bicolor).
+        std::array<std::uint64_t, Pegs> blacks{}, whites{}, order{};
+        std::uint64_t black_seen = 0, white_seen = 0;
+        for (std::size_t pdx = 0; pdx < Pegs; ++pdx) {
+            for (std::size_t ddx = 0; ddx < Disks; ++ddx) {
+
+                std::size_t digit = (std::size_t)(hash % RADIX);
+                hash /= RADIX;
+                if (digit == 0) { continue; }
+
+                std::uint64_t disk = 1ULL << (Disks - ddx - 1);
+                bool black = (digit == 1 || digit >= 3);
+                bool white = (digit == 2 || digit >= 3);
+
+                if ((black && (black_seen & disk)) || (white && (white_seen & disk))) { return false; }
+                if (black) { blacks[pdx] |= disk; black_seen |= disk; }
+                if (white) { whites[pdx] |= disk; white_seen |= disk; }
+                if (digit == 4) { order[pdx] |= disk; }
+            }
+        }
+
+        const std::uint64_t all = (~0ULL >> (64 - Disks));
+        if (black_seen != all || white_seen != (Bicolor ? all : 0)) { return false; }
+
+        _blacks = blacks;
+        _whites = whites;
+        _order  = order;
+
+        this->refreshTracking();
+        return true;
+    }
+
+
+    /* ===========================================================================
+    **  Get a unique descriptor of the state of the game board or the goal state.
+    **
+    ** @return a hash that can be passed to a solving interface.
+    ** =========================================================================== */
+    hash_t getHashableState() const { return _hash; }
+    hash_t getHashableGoal()  const { return GOAL;  }
+
+
+    /* ===========================================================================
+    **  Check if the board is currently in the goal state.
+    **
+    ** @return true if every disk is on its goal peg.
+    ** =========================================================================== */
+    bool isGoal() const { return _misplaced == 0; }
+
+
+    /* ===========================================================================
+    **  Move the top peg from one peg to another.
+    **
+    ** @param from  The source peg.
+    ** @param to    The target peg.
+    **
+    ** @return true if the move was legal and made.
+    ** =========================================================================== */
+    bool move(const int from, const int to) {
+        return planesMove(_blacks, _whites, _order, _hash, _misplaced, Pegs, Disks, Bicolor, POWERS, from, to);
+    }
+
+
+    /* ===========================================================================
+    **  Snapshots of a FixedBoard are plain copies of it, this mirrors the
+    **  snapshot interface of Board so search code can treat boards alike.
+    ** =========================================================================== */
+    typedef FixedBoard Snapshot;
+
+    bool saveSnapshot(FixedBoard& snapshot) const { snapshot = *this; return true; }
+    bool loadSnapshot(const FixedBoard& snapshot) { *this = snapshot; return true; }
+
+    static bool applyMove(const FixedBoard& snapshot, const int from, const int to, FixedBoard& next) {
+        next = snapshot;
+        return next.move(from, to);
+    }
+
+
+    /* ===========================================================================
+    **  Get the legal moves as a mask, numbered as in Board::getLegalMoves.
+    **
+    ** @param [optional] snapshot  the state to find the moves of instead of the board.
+    ** =========================================================================== */
+    std::uint64_t getLegalMoves() const {
+
+        std::array<std::uint64_t, Pegs> tops;
+        for (std::size_t pdx = 0; pdx < Pegs; ++pdx) {
+            std::uint64_t occupied = _blacks[pdx] | _whites[pdx];
+            tops[pdx] = occupied & (~occupied + 1);
+        }
+
+        std::uint64_t mask = 0;
+        std::size_t   bit  = 0;
+        for (std::size_t from = 0; from < Pegs; ++from) {
+            for (std::size_t to = 0; to < Pegs; ++to) {
+                if (from == to) { continue; }
+                if (tops[from] && (tops[to] == 0 || tops[to] >= tops[from])) { mask |= 1ULL << bit; }
+                bit += 1;
+            }
+        }
+
+        return mask;
+    }
+
+    static std::uint64_t getLegalMoves(const FixedBoard& snapshot) { return snapshot.getLegalMoves(); }
+
+
+    private:
+    /* ===========================================================================
+    **  Recompute the hash and misplaced disk count from scratch.
+    ** =========================================================================== */
+    void refreshTracking() {
+
+        _hash = 0;
+        for (std::size_t pdx = 0; pdx < Pegs; ++pdx) {
+            std::uint64_t occupied = _blacks[pdx] | _whites[pdx];
+            while (occupied) {
+                std::size_t bit = __builtin_ctzll(occupied);
+                _hash += planesSlotDigit(_blacks, _whites, _order, pdx, 1ULL << bit) * POWERS[(Disks - bit - 1) + (pdx * Disks)];
+                occupied &= occupied - 1;
+            }
+        }
+
+        //-- Mono disks all go to the last peg, bicolor goes black:0 and white:1.
+        if (Bicolor) {
+            _misplaced  = Disks - __builtin_popcountll(_blacks[0]);
+            _misplaced += Disks - __builtin_popcountll(_whites[1]);
+        } else {
+            _misplaced  = Disks - __builtin_popcountll(_blacks[Pegs-1]);
+        }
+
+        return;
+    }
+
+};
+
+
+/* ================================================================================
+**  Run a visitor on a freshly initialized FixedBoard for the given settings.
+**
+** @return false, without calling the visitor, if the settings were not
+**     instantiated or their hashes do not fit in a hash_t.
+** ================================================================================ */
+template<std::size_t Pegs, std::size_t Disks, bool Bicolor, typename Visitor>
+bool visitFixedBoard(Visitor& visitor) {
+    if constexpr (FixedBoard<Pegs, Disks, Bicolor>::FITS) {
+        FixedBoard<Pegs, Disks, Bicolor> board;
+        board.init();
+        visitor(board);
+        return true;
+    } else {
+        return false;
+    }
+}
+
+template<typename Visitor, std::size_t... Idx>
+bool dispatchFixedBoard(std::size_t key, Visitor& visitor, std::index_sequence<Idx...>) {
+
+    //-- Each key packs (bicolor, pegs, disks) with pegs and disks relative to
+    //-- FIXED_BOARD_MIN, so the fold expands into one compare per instantiation.
+    const std::size_t span = FIXED_BOARD_MAX - FIXED_BOARD_MIN + 1;
+
+    bool found = false;
+    ((key == Idx ? (found = visitFixedBoard<
+        FIXED_BOARD_MIN + ((Idx / span) % span),
+        FIXED_BOARD_MIN + (Idx % span),
+        (Idx / (span * span)) != 0>(visitor)) : false), ...);
+
+    return found;
+}
+
+
+/* ================================================================================
+**  Runtime factory for FixedBoard. Picks the instantiation matching the
+**  given settings, initializes it, and passes it to the visitor.
+**
+** @param pegs     Number of pegs.
+** @param disks    Number of disks.
+** @param bicolor  Whether the game is bicolor.
+** @param visitor  Callable taking any FixedBoard<...>& as its one argument.
+**
+** @return true if a FixedBoard was available and visited.
+** ================================================================================ */
+template<typename Visitor>
+bool dispatchFixedBoard(std::size_t pegs, std::size_t disks, bool bicolor, Visitor&& visitor) {
+
+    if (pegs  < FIXED_BOARD_MIN || pegs  > FIXED_BOARD_MAX) { return false; }
+    if (disks < FIXED_BOARD_MIN || disks > FIXED_BOARD_MAX) { return false; }
+
+    const std::size_t span = FIXED_BOARD_MAX - FIXED_BOARD_MIN + 1;
+    const std::size_t key  = ((bicolor ? 1 : 0) * span * span)
+                           + ((pegs  - FIXED_BOARD_MIN) * span)
+                           +  (disks - FIXED_BOARD_MIN);
+
+    return dispatchFixedBoard(key, visitor, std::make_index_sequence<2 * span * span>());
+}
+
+#endif /* TOWER_OF_HANOI_FIXEDBOARD_HPP */
@@ -15,9 +15,11 @@
 
 #include <atomic>
 #include <chrono>
+#include <future>
 #include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <player.hpp>
 #include <board.hpp>
@@ -35,6 +37,9 @@ class Game {
     std::shared_ptr<Solver> _solver;
     std::atomic<bool>       _running;
 
+    std::shared_future<void>  _solving;       // The solve running in the background, if any.
+    std::chrono::milliseconds _solve_timeout; // How long queries wait on it.
+
     
     public:
     /* ============================================================================
@@ -59,6 +64,15 @@ class Game {
     bool configure(std::map<std::string,std::string> conf);
 
 
+    /* ===========================================================================
+    **  Get the name of every setting configure reads, so the executables can
+    **  pick them out of their arguments.
+    **
+    ** @return the names of the settings.
+    ** =========================================================================== */
+    static const std::vector<std::string>& getConfKeys();
+
+
     /* ===========================================================================
     **  Entry point for the game's start.
     **
@@ -68,6 +82,26 @@ class Game {
 
 
     private:
+    /* ===========================================================================
+    **  Wait for the background solve to finish, up to the solve timeout.
+    **
+    ** @return true if the solver can be queried.
+    ** =========================================================================== */
+    bool waitForSolver();
+
+
+    /* ===========================================================================
+    **  Read an unsigned integer setting from the configuration.
+    **
+    ** @param conf      variables for configuring the game environment.
+    ** @param key       name of the setting.
+    ** @param fallback  value used if the setting is missing or malformed.
+    **
+    ** @return the value of the setting.
+    ** =========================================================================== */
+    std::size_t getConfValue(std::map<std::string,std::string>& conf, const std::string& key, std::size_t fallback);
+
+
     /* ===========================================================================
     **  Temp.
     ** =========================================================================== */
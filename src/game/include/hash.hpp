@@ -0,0 +1,96 @@
+/* ================================================================================
+ * Copyright: (C) 2022, SIRRL Social and Intelligent Robotics Research Laboratory, 
+ *     University of Waterloo, All rights reserved.
+ * 
+ * Authors: 
+ *     Austin Kothig <austin.kothig@uwaterloo.ca>
+ * 
+ * CopyPolicy: Released under the terms of the MIT License. 
+ *     See the accompanying LICENSE file for details.
+ * ================================================================================
+ */
+
+#ifndef TOWER_OF_HANOI_HASH_HPP
+#define TOWER_OF_HANOI_HASH_HPP
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+
+/* ================================================================================
+**  Type used for board hashes and ranks. Defaults to 64 bits, which covers
+**  bicolor boards up to pegs*disks <= 27 and mono boards up to pegs*disks <= 64.
+**  Configure with USE_WIDE_HASH to switch to 128 bits for larger boards.
+** ================================================================================ */
+#ifdef TOWER_OF_HANOI_WIDE_HASH
+typedef unsigned __int128  hash_t;
+#else
+typedef unsigned long long hash_t;
+#endif
+
+
+/* ================================================================================
+**  Hasher so hash_t can key unordered containers regardless of its width.
+** ================================================================================ */
+struct HashHasher {
+    std::size_t operator()(const hash_t& hash) const {
+#ifdef TOWER_OF_HANOI_WIDE_HASH
+        unsigned long long lo = (unsigned long long)(hash);
+        unsigned long long hi = (unsigned long long)(hash >> 64);
+        return std::hash<unsigned long long>()(lo ^ (hi * 0x9E3779B97F4A7C15ULL));
+#else
+        return std::hash<unsigned long long>()(hash);
+#endif
+    }
+};
+
+
+/* ================================================================================
+**  Convert a hash to its decimal string.
+**
+** @param hash  the hash to convert.
+**
+** @return the hash written in base 10.
+** ================================================================================ */
+inline std::string hashToString(hash_t hash) {
+
+    if (hash == 0) { return "0"; }
+
+    std::string ret = "";
+    while (hash) {
+        ret.insert(ret.begin(), (char)('0' + (int)(hash % 10)));
+        hash /= 10;
+    }
+
+    return ret;
+}
+
+
+/* ================================================================================
+**  Parse a hash from a string of decimal digits.
+**
+** @param str   the string to parse.
+** @param hash  where the parsed value is written.
+**
+** @return false if the string is empty, not all digits, or does not fit a hash_t.
+** ================================================================================ */
+inline bool stringToHash(const std::string& str, hash_t& hash) {
+
+    if (str.empty()) { return false; }
+
+    hash_t value = 0;
+    const hash_t limit = ~((hash_t)0);
+    for (char c : str) {
+        if (c < '0' || c > '9') { return false; }
+
+        hash_t digit = (hash_t)(c - '0');
+        if (value > (limit - digit) / 10) { return false; }
+        value = (value * 10) + digit;
+    }
+
+    hash = value;
+    return true;
+}
+
+#endif /* TOWER_OF_HANOI_HASH_HPP */
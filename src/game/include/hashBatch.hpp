@@ -0,0 +1,62 @@
+/* ================================================================================
+ * Copyright: (C) 2022, SIRRL Social and Intelligent Robotics Research Laboratory, 
+ *     University of Waterloo, All rights reserved.
+ * 
+ * Authors: 
+ *     Austin Kothig <austin.kothig@uwaterloo.ca>
+ * 
+ * CopyPolicy: Released under the terms of the MIT License. 
+ *     See the accompanying LICENSE file for details.
+ * ================================================================================
+ */
+
+#ifndef TOWER_OF_HANOI_HASH_BATCH_HPP
+#define TOWER_OF_HANOI_HASH_BATCH_HPP
+
+#include <cstddef>
+
+#include <hash.hpp>
+
+
+/* ================================================================================
+**  Batched conversions between board hashes and their encodings (see
+**  Board::generateEncoding). Encodings are laid out one state after another,
+**  `slots` digits each. Uses AVX2 when the CPU has it and hash_t is 64 bits,
+**  four states at a time, otherwise falls back to scalar code.
+** ================================================================================ */
+
+
+/* ================================================================================
+**  Encode many states at once.
+**
+** @param encodings  count*slots digits, the encodings of each state in turn.
+** @param count      the number of states.
+** @param slots      the number of digits per state (pegs * disks).
+** @param radix      the base of each digit, 2 for mono or 5 for bicolor.
+** @param hashes     where the count hashes are written.
+** ================================================================================ */
+void encodeHashes(const std::size_t* encodings, std::size_t count, std::size_t slots,
+                  std::size_t radix, hash_t* hashes);
+
+
+/* ================================================================================
+**  Decode many states at once.
+**
+** @param hashes     the count hashes to decode.
+** @param count      the number of states.
+** @param slots      the number of digits per state (pegs * disks).
+** @param radix      the base of each digit, 2 for mono or 5 for bicolor.
+** @param encodings  where the count*slots digits are written.
+** ================================================================================ */
+void decodeHashes(const hash_t* hashes, std::size_t count, std::size_t slots,
+                  std::size_t radix, std::size_t* encodings);
+
+
+/* ================================================================================
+**  Check if the batched conversions run vectorized on this machine.
+**
+** @return true if the AVX2 kernels are compiled in and supported by the CPU.
+** ================================================================================ */
+bool hashBatchIsVectorized();
+
+#endif /* TOWER_OF_HANOI_HASH_BATCH_HPP */
@@ -0,0 +1,188 @@
+/* ================================================================================
+ * Copyright: (C) 2022, SIRRL Social and Intelligent Robotics Research Laboratory, 
+ *     University of Waterloo, All rights reserved.
+ * 
+ * Authors: 
+ *     Austin Kothig <austin.kothig@uwaterloo.ca>
+ * 
+ * CopyPolicy: Released under the terms of the MIT License. 
+ *     See the accompanying LICENSE file for details.
+ * ================================================================================
+ */
+
+#ifndef TOWER_OF_HANOI_MAPPED_TABLE_HPP
+#define TOWER_OF_HANOI_MAPPED_TABLE_HPP
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include <board.hpp>
+
+
+/* ================================================================================
+**  A solved board saved to a file and read back by mapping it into memory
+**  read-only, so no search is needed at start up, and every process using
+**  the same file shares its pages through the page cache. The file holds a
+**  header of the format version and board settings, then the distance of
+**  each rank, then the best move of each rank. The same layout can instead
+**  live in a named POSIX shared memory object, solved by the first process
+**  of a host and attached by the rest.
+** ================================================================================ */
+class MappedTable {
+
+    private:
+    /* ============================================================================
+    **  Private variables of the mapped table.
+    ** ============================================================================ */
+    const std::uint8_t*  _data;  // Start of the mapping, or null if not open.
+    std::size_t          _size;  // Bytes mapped.
+    const std::uint32_t* _dist;  // Distance of each rank, UINT32_MAX if unreached.
+    const std::uint8_t*  _moves; // Index of the best move of each rank, UINT8_MAX if none.
+    hash_t               _count; // Number of ranks.
+
+
+    public:
+    /* ============================================================================
+    **  Main Constructor. The table starts closed.
+    ** ============================================================================ */
+    MappedTable();
+
+
+    /* ===========================================================================
+    **  Destructor. Unmaps the file.
+    ** =========================================================================== */
+    ~MappedTable();
+
+
+    /* ===========================================================================
+    **  Write the table of a solved board to a file. The file is written under
+    **  a unique temporary name next to it and renamed, so a process never
+    **  maps it half written. The temporary file is removed if anything fails.
+    **
+    ** @param path      the file to write.
+    ** @param board     a board with the settings solved, which fits a snapshot.
+    ** @param distance  gives the distance of a state, or false if unreached.
+    **
+    ** @return false if the file could not be written.
+    ** =========================================================================== */
+    static bool save(const std::string& path, Board& board,
+                     const std::function<bool(const BoardSnapshot&, ull&)>& distance);
+
+
+    /* ===========================================================================
+    **  Map a table file, closing any table already open.
+    **
+    ** @param path   the file to map.
+    ** @param board  a board with the settings the file must have been made for.
+    **
+    ** @return false if the file could not be mapped, or is of another version,
+    **     byte order, settings or size.
+    ** =========================================================================== */
+    bool open(const std::string& path, Board& board);
+
+
+    /* ===========================================================================
+    **  Map a table from shared memory, closing any table already open. The
+    **  first process to ask solves and fills it while holding a lock on the
+    **  object, and the others wait on that lock and then attach to it.
+    **
+    ** @param name      the name of the shared memory object (see getSharedName).
+    ** @param board     a board with the settings the table is made for.
+    ** @param solve     solves the board, only called if the table is not ready.
+    ** @param distance  gives the distance of a state once solved, or false 
+    **     if unreached.
+    **
+    ** @return false if shared memory could not be used, or the solve failed.
+    ** =========================================================================== */
+    bool openShared(const std::string& name, Board& board, const std::function<bool()>& solve,
+                    const std::function<bool(const BoardSnapshot&, ull&)>& distance);
+
+
+    /* ===========================================================================
+    **  Unmap the table file.
+    ** =========================================================================== */
+    void close();
+
+
+    /* ===========================================================================
+    **  Check if a table file is mapped.
+    **
+    ** @return true if lookups can be made.
+    ** =========================================================================== */
+    bool isOpen();
+
+
+    /* ===========================================================================
+    **  Read the distance of a rank.
+    **
+    ** @param rank  a dense index of a board state.
+    ** @param dist  where the distance is written.
+    **
+    ** @return false if the table is not open, or the rank was never reached.
+    ** =========================================================================== */
+    bool lookup(hash_t rank, ull& dist);
+
+
+    /* ===========================================================================
+    **  Read the best move of a rank.
+    **
+    ** @param rank   a dense index of a board state.
+    ** @param index  where the index of the move is written, in the order of
+    **     the board's legal move mask (see Board::getMoveFromIndex).
+    **
+    ** @return false if the table is not open, or the rank has no move.
+    ** =========================================================================== */
+    bool getBestMove(hash_t rank, std::size_t& index);
+
+
+    /* ===========================================================================
+    **  Get the file name a table is saved under.
+    **
+    ** @param pegs       the number of pegs.
+    ** @param disks      the number of disks.
+    ** @param isBicolor  whether the board is bicolor.
+    **
+    ** @return a file name, without a directory.
+    ** =========================================================================== */
+    static std::string getFileName(std::size_t pegs, std::size_t disks, bool isBicolor);
+
+
+    /* ===========================================================================
+    **  Get the name a table is shared under.
+    **
+    ** @param pegs       the number of pegs.
+    ** @param disks      the number of disks.
+    ** @param isBicolor  whether the board is bicolor.
+    **
+    ** @return a shared memory object name, starting with a slash.
+    ** =========================================================================== */
+    static std::string getSharedName(std::size_t pegs, std::size_t disks, bool isBicolor);
+
+
+    /* ===========================================================================
+    **  Remove a shared table from the host. Processes that have it mapped
+    **  keep their mapping, and the next to ask solves it again.
+    **
+    ** @param name  the name of the shared memory object.
+    **
+    ** @return false if there was no such object.
+    ** =========================================================================== */
+    static bool removeShared(const std::string& name);
+
+
+    private:
+    /* ===========================================================================
+    **  Map an open file or shared memory object, if it holds a finished table
+    **  for the board.
+    **
+    ** @param fd     the descriptor to map, which may be closed after.
+    ** @param board  a board with the settings the table must be made for.
+    **
+    ** @return false if it could not be mapped, or is of another version,
+    **     byte order, settings or size, or is not finished.
+    ** =========================================================================== */
+    bool attach(int fd, Board& board);
+};
+
+#endif /* TOWER_OF_HANOI_MAPPED_TABLE_HPP */
@@ -0,0 +1,123 @@
+/* ================================================================================
+ * Copyright: (C) 2022, SIRRL Social and Intelligent Robotics Research Laboratory, 
+ *     University of Waterloo, All rights reserved.
+ * 
+ * Authors: 
+ *     Austin Kothig <austin.kothig@uwaterloo.ca>
+ * 
+ * CopyPolicy: Released under the terms of the MIT License. 
+ *     See the accompanying LICENSE file for details.
+ * ================================================================================
+ */
+
+#ifndef TOWER_OF_HANOI_PATTERN_DATABASE_HPP
+#define TOWER_OF_HANOI_PATTERN_DATABASE_HPP
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <board.hpp>
+
+
+/* ================================================================================
+**  Exact distances to the goal for every arrangement of a subset of the disks,
+**  taken on their own. Leaving disks out only lifts constraints, so the table
+**  is a lower bound on the full board, and the tables of disjoint subsets can
+**  be added together since every move moves a disk of only one subset. Only
+**  the relative sizes of the subset matter, so one table serves any subset of
+**  the same number of disks.
+** ================================================================================ */
+class PatternDatabase {
+
+    private:
+    /* ============================================================================
+    **  Private variables of the pattern database.
+    ** ============================================================================ */
+    std::shared_ptr<Board>     _board; // Board holding only the pattern's disks.
+    std::vector<std::uint16_t> _table; // Distance of each rank of _board to its goal.
+
+
+    public:
+    /* ============================================================================
+    **  Main Constructor.
+    **
+    ** @param pegs       the number of pegs of the full board.
+    ** @param disks      the number of disks in the pattern.
+    ** @param isBicolor  whether the full board is bicolor.
+    ** ============================================================================ */
+    PatternDatabase(std::size_t pegs=3, std::size_t disks=3, bool isBicolor=false);
+
+
+    /* ===========================================================================
+    **  Destructor.
+    ** =========================================================================== */
+    ~PatternDatabase();
+
+
+    /* ===========================================================================
+    **  Fill the table with a breadth-first search from the goal over ranks.
+    **
+    ** @return false if the pattern board could not be set, is too wide for a
+    **     snapshot, or has a distance too large for the table.
+    ** =========================================================================== */
+    bool build();
+
+
+    /* ===========================================================================
+    **  Write the table to, or read it from, a binary file. The file starts
+    **  with a header of the pattern's settings, and the distances follow in
+    **  rank order in the machine's byte order.
+    **
+    ** @param path  the file to write or read.
+    **
+    ** @return false if the file could not be written, or could not be read or
+    **     was made for other settings. The table is unchanged if load fails.
+    ** =========================================================================== */
+    bool save(const std::string& path);
+    bool load(const std::string& path);
+
+
+    /* ===========================================================================
+    **  Check if the table has been built or loaded.
+    **
+    ** @return true if lookups can be made.
+    ** =========================================================================== */
+    bool isBuilt();
+
+
+    /* ===========================================================================
+    **  Get the number of disks in the pattern.
+    **
+    ** @return the disks of the pattern board.
+    ** =========================================================================== */
+    std::size_t getNumDisks();
+
+
+    /* ===========================================================================
+    **  Look up the distance of the pattern's disks within a full board state.
+    **
+    ** @param state  a snapshot of the full board.
+    ** @param disks  the bits of the disks in the pattern, in the full board's
+    **     planes. Must have exactly getNumDisks() bits set.
+    **
+    ** @return the moves the pattern's disks need on their own to reach the goal.
+    ** =========================================================================== */
+    ull lookup(const BoardSnapshot& state, std::uint64_t disks);
+
+
+    /* ===========================================================================
+    **  Get the file name a table is saved under, so one built for some settings
+    **  is found again by later runs.
+    **
+    ** @param pegs       the number of pegs of the full board.
+    ** @param disks      the number of disks in the pattern.
+    ** @param isBicolor  whether the full board is bicolor.
+    **
+    ** @return a file name, without a directory.
+    ** =========================================================================== */
+    static std::string getFileName(std::size_t pegs, std::size_t disks, bool isBicolor);
+};
+
+#endif /* TOWER_OF_HANOI_PATTERN_DATABASE_HPP */
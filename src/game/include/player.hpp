@@ -18,9 +18,11 @@
 #include <string>
 #include <vector>
 
+#include <hash.hpp>
+
 
 struct action {
-    int from, to; unsigned long long hash; std::string msg;
+    int from, to; hash_t hash; std::string msg;
     enum { HELP, MOVE, STATUS, GOAL, HINT, HASH, DIST, SET, QUIT } selection;
 };
 
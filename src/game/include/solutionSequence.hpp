@@ -0,0 +1,142 @@
+/* ================================================================================
+ * Copyright: (C) 2022, SIRRL Social and Intelligent Robotics Research Laboratory, 
+ *     University of Waterloo, All rights reserved.
+ * 
+ * Authors: 
+ *     Austin Kothig <austin.kothig@uwaterloo.ca>
+ * 
+ * CopyPolicy: Released under the terms of the MIT License. 
+ *     See the accompanying LICENSE file for details.
+ * ================================================================================
+ */
+
+#ifndef TOWER_OF_HANOI_SOLUTION_SEQUENCE_HPP
+#define TOWER_OF_HANOI_SOLUTION_SEQUENCE_HPP
+
+#include <cstddef>
+#include <iterator>
+#include <utility>
+
+#include <hash.hpp>
+
+
+typedef std::pair<int,int> pii;
+typedef unsigned long long ull;
+
+
+/* ================================================================================
+**  The optimal move sequence of the classic 3 peg mono game, from every disk
+**  on peg 0 to every disk on peg 2, worked out one move at a time and never
+**  stored. Move k (counting from 1) moves the disk of size ctz(k)+1, and
+**  each disk steps around the pegs in a fixed direction, so both the k-th
+**  move and the state after k moves take O(disks).
+** ================================================================================ */
+class SolutionSequence {
+
+    private:
+    /* ============================================================================
+    **  Private variables of the solution sequence.
+    ** ============================================================================ */
+    std::size_t _num_disk; // Number of disks.
+
+
+    public:
+    //-- Most disks whose sequence length fits a ull.
+    static constexpr std::size_t MAX_DISKS = 64;
+
+
+    /* ============================================================================
+    **  Forward iterator over the moves, for use in range based loops.
+    ** ============================================================================ */
+    class iterator {
+        const SolutionSequence* _sequence;
+        ull                     _index;
+
+        public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef pii                       value_type;
+        typedef long long                 difference_type;
+        typedef const pii*                pointer;
+        typedef pii                       reference;
+
+        iterator(const SolutionSequence* sequence, ull index) : _sequence(sequence), _index(index) {}
+
+        pii       operator*()                     const { return _sequence->getMove(_index); }
+        iterator& operator++()                          { ++_index; return *this; }
+        bool      operator==(const iterator& rhs) const { return _index == rhs._index; }
+        bool      operator!=(const iterator& rhs) const { return _index != rhs._index; }
+    };
+
+
+    /* ============================================================================
+    **  Main Constructor.
+    **
+    ** @param disks  the number of disks, at most MAX_DISKS (see isValid).
+    ** ============================================================================ */
+    SolutionSequence(std::size_t disks=3);
+
+
+    /* ===========================================================================
+    **  Check if the sequence has few enough disks to be worked out. Sequences
+    **  of more than MAX_DISKS disks are empty.
+    **
+    ** @return true if the number of disks is at most MAX_DISKS.
+    ** =========================================================================== */
+    bool isValid() const;
+
+
+    /* ===========================================================================
+    **  Get the number of moves in the sequence.
+    **
+    ** @return 2^disks - 1, or 0 if the sequence is not valid.
+    ** =========================================================================== */
+    ull getLength() const;
+
+
+    /* ===========================================================================
+    **  Get a move of the sequence.
+    **
+    ** @param index  the number of moves made before it, in [0, getLength()).
+    **
+    ** @return the pegs to move from and to, or (-1,-1) if out of range.
+    ** =========================================================================== */
+    pii getMove(ull index) const;
+
+
+    /* ===========================================================================
+    **  Get the peg a disk is on after some moves of the sequence.
+    **
+    ** @param moves  the number of moves made, at most getLength().
+    ** @param size   the size of the disk, from 1 for the smallest up to the
+    **     number of disks.
+    **
+    ** @return the peg of the disk, or -1 if the size or moves are out of range.
+    ** =========================================================================== */
+    int getPeg(ull moves, std::size_t size) const;
+
+
+    /* ===========================================================================
+    **  Get the rank of the state after some moves of the sequence, as used by
+    **  Board::getRankedState on a 3 peg mono board of as many disks.
+    **
+    ** @param moves  the number of moves made, at most getLength().
+    ** @param rank   where the rank is written.
+    **
+    ** @return false if the sequence is not valid, moves is out of range, or the
+    **     rank does not fit a hash_t.
+    ** =========================================================================== */
+    bool getRankAfter(ull moves, hash_t& rank) const;
+
+
+    /* ===========================================================================
+    **  Iterate over the moves from the first, or from any index.
+    **
+    ** @param [optional] index  the number of moves to skip.
+    **
+    ** @return an iterator at the given move, or one past the last.
+    ** =========================================================================== */
+    iterator begin(ull index=0) const;
+    iterator end()              const;
+};
+
+#endif /* TOWER_OF_HANOI_SOLUTION_SEQUENCE_HPP */
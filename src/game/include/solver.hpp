@@ -13,49 +13,165 @@
 #ifndef TOWER_OF_HANOI_SOLVER_HPP
 #define TOWER_OF_HANOI_SOLVER_HPP
 
+#include <cstdint>
 #include <memory>
 #include <unordered_map>
+#include <unordered_set>
 #include <queue>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include <bicolorDistance.hpp>
 #include <board.hpp>
+#include <diskTable.hpp>
+#include <fixedBoard.hpp>
+#include <mappedTable.hpp>
+#include <patternDatabase.hpp>
 
 
 typedef std::pair<int,int> pii;
 typedef unsigned long long ull;
 
 struct move {
-    int from, to;
-    ull hash;
-    ull dist;
+    int    from, to;
+    hash_t hash;
+    ull    dist;
 };
 
 typedef std::vector<move> mvec;
 
 
+/* ================================================================================
+**  Options for how the solver searches and stores its solution.
+** ================================================================================ */
+struct solverOptions {
+    bool symmetry = false; // Store only canonical states (see Board::getCanonicalState).
+
+    //-- BFS solves every state up front. ASTAR searches only from the states
+    //-- that are asked about, and caches the path it finds to the goal. 
+    //-- IDASTAR does the same by iterative deepening, which keeps only the 
+    //-- current path and a bounded table of seen states in memory, guided by
+    //-- pattern databases. BIDIRECTIONAL grows breadth-first frontiers from
+    //-- both the state and the goal until they meet. ANALYTIC works out the
+    //-- answer of a 3 peg board from its hash alone: in closed form for mono,
+    //-- and for bicolor one size at a time (see BicolorDistance), after
+    //-- setting aside the largest sizes already in place. It falls back to
+    //-- BFS on other boards.
+    enum Search { BFS, ASTAR, IDASTAR, BIDIRECTIONAL, ANALYTIC } search = BFS;
+
+    //-- Most states a single query search may generate before giving up, 
+    //-- zero for no limit.
+    std::size_t max_nodes = 0;
+
+    //-- Single query searches also solve the states within local_depth moves
+    //-- of each state asked about, so the next queries as the player moves
+    //-- are already cached. At most local_states are searched per region, 
+    //-- zero for no limit. A local_depth of zero solves only the state asked.
+    std::size_t local_depth  = 0;
+    std::size_t local_states = 0;
+
+    //-- MAP keeps the moves of every state in a hash map. FLAT keeps one
+    //-- distance per state in an array indexed by rank, and regenerates moves.
+    //-- DISK keeps that array in a file, searched with bounded memory.
+    enum Storage { MAP, FLAT, DISK } storage = MAP;
+
+    //-- Worker threads of the FLAT search, which expands each level of the
+    //-- breadth-first search in parallel. Zero uses one per core.
+    std::size_t threads = 1;
+
+    //-- Most disks in each pattern database of the IDASTAR search, zero to
+    //-- fit each table in about a million entries.
+    std::size_t pdb_disks = 0;
+
+    //-- Directory the DISK search writes its files and table to, and the
+    //-- most states it holds in memory at once.
+    std::string disk_path   = ".";
+    std::size_t disk_buffer = 1 << 22;
+
+    //-- Directory the pattern databases are loaded from, and saved to when
+    //-- they have to be built. Empty to build them every time.
+    std::string pdb_path = "";
+
+    //-- Directory of precomputed tables. A breadth-first solve maps the
+    //-- table for its settings from here if there is one, and otherwise
+    //-- solves and saves it here. Empty to always solve.
+    std::string table_path = "";
+
+    //-- Share the table of a breadth-first solve with every process of the
+    //-- host that has the same settings, through POSIX shared memory. The 
+    //-- first to solve fills it, and the rest map it read-only.
+    bool shared = false;
+};
+
+
 class Solver {
 
     private:
     /* ============================================================================
     **  Private variables of the solver.
     ** ============================================================================ */
-    std::shared_ptr<Board>       _board;
-    std::unordered_map<ull,mvec> _sssp;
-    std::unordered_map<ull,ull>  _dist;
-    std::vector<pii>             _moves;
+    std::shared_ptr<Board>                     _board;
+    std::unordered_map<hash_t,mvec,HashHasher> _sssp;
+    std::unordered_map<hash_t,ull,HashHasher>  _dist;
+    std::vector<pii>                           _moves;
+    std::vector<std::uint32_t>                 _table; // Distance of each rank, for FLAT storage.
+    std::unordered_map<hash_t,pii,HashHasher>  _next;  // Next move along paths found by ASTAR.
+    std::unordered_set<hash_t,HashHasher>      _explored; // States whose region has been solved.
+    std::shared_ptr<DiskTable>                 _disk_table; // Distances of DISK storage.
+    std::shared_ptr<MappedTable>               _mapped_table; // Precomputed table, once mapped.
+
+    //-- Pattern databases of the IDASTAR search, each with the disks it covers.
+    std::vector<std::shared_ptr<PatternDatabase>> _patterns;
+    std::vector<std::uint64_t>                    _pattern_disks;
+
+    //-- Least cost each state was expanded at in the current IDASTAR pass, 
+    //-- up to a fixed number of states.
+    static constexpr std::size_t TRANSPOSITION_LIMIT = 1 << 20;
+    std::unordered_map<hash_t,ull,HashHasher> _transpositions;
+
+    //-- Tower costs of each size, for ANALYTIC answers on bicolor boards.
+    std::shared_ptr<BicolorDistance> _bicolor_distance;
+
+    //-- Where a BFS solve keeps its states. MAP keeps them in _sssp and _dist,
+    //-- CANONICAL does the same for canonical states only, FLAT keeps them in
+    //-- _table and DISK in _disk_table. MAPPED is a precomputed table in
+    //-- _mapped_table, which takes over from the others once it is mapped.
+    enum Storage { MAP, CANONICAL, FLAT, DISK, MAPPED };
     
-    bool _solved;
-    ull  _start_hash;
-    ull  _goal_hash;
+    bool   _solved;
+    bool   _shared;    // Whether the table of a BFS solve is shared through shared memory.
+
+    solverOptions::Search _search;  // How states are solved, BFS if the board can't use the one asked for.
+    Storage               _storage; // Where a BFS solve keeps its states.
+
+    std::size_t _max_nodes; // Most states a single query search may generate.
+
+    std::size_t _local_depth;  // Moves around each query that are solved too.
+    std::size_t _local_states; // Most states solved per region.
+
+    std::size_t _threads; // Worker threads of the FLAT search.
+
+    std::size_t _pdb_disks; // Most disks in each pattern database.
+    std::string _pdb_path;  // Where pattern databases are kept, if anywhere.
+
+    std::string _table_path; // Where precomputed tables are kept, if anywhere.
+
+    hash_t _start_hash;
+    hash_t _goal_hash;
 
   
     public:
     /* ============================================================================
     **  Main Constructor.
+    **
+    ** @param options  how to search and store the solution. Everything but the 
+    **     defaults needs a board that fits a BoardSnapshot, and is otherwise 
+    **     ignored. Searches other than BFS ignore storage and symmetry, FLAT 
+    **     and DISK storage ignore symmetry.
     ** ============================================================================ */
-    Solver(std::size_t pegs=3, std::size_t disks=3, bool isBicolor=false);
+    Solver(std::size_t pegs=3, std::size_t disks=3, bool isBicolor=false, 
+           const solverOptions& options=solverOptions());
 
 
     /* ===========================================================================
@@ -67,6 +183,8 @@ class Solver {
     /* ===========================================================================
     **  Perform a single-source shortest path search from the goal state 
     **  to all existing states for quick look ups of the next best move.
+    **  With a table path, map the precomputed table instead if it exists,
+    **  or save one after searching.
     ** =========================================================================== */
     void solve();
 
@@ -78,7 +196,7 @@ class Solver {
     **
     ** @return a pair of ints that represent the next best move.
     ** =========================================================================== */
-    pii getBestMove(ull hash);
+    pii getBestMove(hash_t hash);
 
 
     /* ===========================================================================
@@ -88,7 +206,7 @@ class Solver {
     **
     ** @return an unsigned long long telling the distance .
     ** =========================================================================== */
-    ull getDistance(ull hash);
+    ull getDistance(hash_t hash);
 
 
     /* ===========================================================================
@@ -100,6 +218,281 @@ class Solver {
 
 
     private:
+    /* ===========================================================================
+    **  Solve every state with the breadth-first search that suits the board.
+    ** =========================================================================== */
+    void searchTable();
+
+
+    /* ===========================================================================
+    **  Breadth-first search from the goal state over the given board. Used with
+    **  a FixedBoard when one is instantiated for the settings, else the Board.
+    **
+    ** @param board  a board with the solver's settings to search with.
+    ** =========================================================================== */
+    template<typename BoardType>
+    void search(BoardType& board);
+
+
+    /* ===========================================================================
+    **  Breadth-first search from the goal state that sets the board from each
+    **  hash and undoes every move. Used for boards too wide for a snapshot.
+    **
+    ** @param board  a board with the solver's settings to search with.
+    ** =========================================================================== */
+    void searchByHash(Board& board);
+
+
+    /* ===========================================================================
+    **  Breadth-first search from the goal state that only visits canonical
+    **  states. Entries are keyed by canonical hash, with moves and successor
+    **  hashes written in terms of the canonical state's pegs.
+    **
+    ** @param board  a board with the solver's settings to search with.
+    ** =========================================================================== */
+    void searchCanonical(Board& board);
+
+
+    /* ===========================================================================
+    **  Level-synchronous breadth-first search from the goal state that fills 
+    **  the flat table of distances by rank. Each level is a list of ranks that
+    **  the worker threads expand together.
+    **
+    ** @param board  a board with the solver's settings to search with.
+    ** =========================================================================== */
+    void searchFlat(Board& board);
+
+
+    /* ===========================================================================
+    **  Breadth-first search from the goal state that keeps its layers and the
+    **  table of distances by rank in files (see DiskTable).
+    **
+    ** @param board  a board with the solver's settings to search with.
+    ** =========================================================================== */
+    void searchDisk(Board& board);
+
+
+    /* ===========================================================================
+    **  Map the precomputed table for the board's settings, if one was saved.
+    **
+    ** @return false if there is no table path, or no valid table in it.
+    ** =========================================================================== */
+    bool mapTable();
+
+
+    /* ===========================================================================
+    **  Save the solved distances and best moves as a precomputed table.
+    ** =========================================================================== */
+    void saveTable();
+
+
+    /* ===========================================================================
+    **  Map the table for the board's settings from shared memory, solving and
+    **  filling it first if no other process has.
+    **
+    ** @return false if tables are not shared, or shared memory failed.
+    ** =========================================================================== */
+    bool shareTable();
+
+
+    /* ===========================================================================
+    **  Answer every query from a mapped table, and free the solver's own.
+    **
+    ** @param table  an open table for the board's settings.
+    ** =========================================================================== */
+    void useTable(std::shared_ptr<MappedTable> table);
+
+
+    /* ===========================================================================
+    **  Solve every state with the search that suits the storage.
+    ** =========================================================================== */
+    void searchStorage();
+
+
+    /* ===========================================================================
+    **  A* search from the given state to the goal, guided by the board's lower
+    **  bound. Every state on the path found is cached with its exact distance
+    **  and next move, and the search stops early on reaching a cached state.
+    **
+    ** @param start  the hash of the state to search from.
+    **
+    ** @return false if the hash is not a valid state of the board, or the 
+    **     search generated more states than allowed.
+    ** =========================================================================== */
+    bool searchAStar(hash_t start);
+
+
+    /* ===========================================================================
+    **  Iterative deepening A* search from the given state to the goal, guided
+    **  by the pattern databases, which are loaded or built on first use. The
+    **  path found is cached as with searchAStar.
+    **
+    ** @param start  the hash of the state to search from.
+    **
+    ** @return false if the hash is not a valid state of the board, the pattern
+    **     databases could not be built, or the search expanded more states 
+    **     than allowed.
+    ** =========================================================================== */
+    bool searchIDAStar(hash_t start);
+
+
+    /* ===========================================================================
+    **  One depth-first pass of searchIDAStar below the end of the path. Never
+    **  moves the same disk twice in a row, since that is never shortest, and
+    **  skips states already expanded as cheaply in the pass.
+    **
+    ** @param path   the states from the start, extended in place.
+    ** @param moves  the moves between the states of the path.
+    ** @param bound  the most moves a path may be estimated to take.
+    ** @param nodes  the count of states expanded so far.
+    ** @param found  set once the path reaches the goal or a cached state.
+    ** @param rest   where the exact distance of the path's last state is written.
+    **
+    ** @return the estimated total of the path found, or else the least estimate 
+    **     above the bound, which is ULLONG_MAX if there was none.
+    ** =========================================================================== */
+    ull deepen(std::vector<BoardSnapshot>& path, std::vector<pii>& moves, ull bound, 
+               std::size_t& nodes, bool& found, ull& rest);
+
+
+    /* ===========================================================================
+    **  Split the disks into groups, from the largest down, and load or build a
+    **  pattern database for each group size.
+    **
+    ** @return false if a pattern database could not be built.
+    ** =========================================================================== */
+    bool loadPatterns();
+
+
+    /* ===========================================================================
+    **  Load a pattern database from the pattern directory, or build it and
+    **  save it there.
+    **
+    ** @param count  the number of disks in the pattern.
+    **
+    ** @return the pattern database, or null if it could not be built.
+    ** =========================================================================== */
+    std::shared_ptr<PatternDatabase> loadPattern(std::size_t count);
+
+
+    /* ===========================================================================
+    **  Get the most disks a pattern database should hold, from the options
+    **  or else the most that keep a table near a million entries.
+    **
+    ** @return a number of disks, at least 3 and at most the board's.
+    ** =========================================================================== */
+    std::size_t getPatternSize();
+
+
+    /* ===========================================================================
+    **  Answer a query without searching, for the ANALYTIC mode.
+    **
+    ** @param hash  the hash corresponding to a board state. 
+    ** @param dist  where the distance to the goal is written.
+    ** @param [optional] best  where the next best move is written, or (-1,-1)
+    **     for the goal and invalid states, which have distance 0.
+    ** =========================================================================== */
+    void answerAnalytic(hash_t hash, ull& dist, pii* best=nullptr);
+
+
+    /* ===========================================================================
+    **  Estimate the distance of a state to the goal, as the larger of the 
+    **  board's lower bound and the sum of the pattern databases.
+    **
+    ** @param state  the state to estimate.
+    **
+    ** @return an admissible estimate of the distance to the goal.
+    ** =========================================================================== */
+    ull estimate(const BoardSnapshot& state);
+
+
+    /* ===========================================================================
+    **  Bidirectional breadth-first search between the given state and the
+    **  goal. The side with the smaller frontier expands a whole level at a 
+    **  time, and the search stops after the level where the sides first meet.
+    **  The path found is cached as with searchAStar.
+    **
+    ** @param start  the hash of the state to search from.
+    **
+    ** @return false if the hash is not a valid state of the board, or the 
+    **     search generated more states than allowed.
+    ** =========================================================================== */
+    bool searchBidirectional(hash_t start);
+
+
+    /* ===========================================================================
+    **  Solve a single query with the configured search (see searchAStar), 
+    **  then the region around it.
+    **
+    ** @param start  the hash of the state to search from.
+    **
+    ** @return false if the search of the state itself failed.
+    ** =========================================================================== */
+    bool searchQuery(hash_t start);
+
+
+    /* ===========================================================================
+    **  Solve a single state with the configured search, and nothing around it.
+    **
+    ** @param start  the hash of the state to search from.
+    **
+    ** @return false if the search failed.
+    ** =========================================================================== */
+    bool searchSingle(hash_t start);
+
+
+    /* ===========================================================================
+    **  Solve every state within the local depth of a state, nearest first,
+    **  until the local state budget is spent. Each region is only explored
+    **  once, and states already cached are not searched again.
+    **
+    ** @param center  the hash of the state in the middle of the region.
+    ** =========================================================================== */
+    void searchRegion(hash_t center);
+
+
+    /* ===========================================================================
+    **  Look up the distance of a state from the goal.
+    **
+    ** @param state  the state to look up.
+    ** @param dist   where the distance is written.
+    **
+    ** @return false if the state was never reached.
+    ** =========================================================================== */
+    bool findDistance(const BoardSnapshot& state, ull& dist);
+
+
+    /* ===========================================================================
+    **  Regenerate the moves of a state from the flat table.
+    **
+    ** @param state        the state to expand.
+    ** @param state_moves  where the moves are written.
+    ** =========================================================================== */
+    void generateMoves(const BoardSnapshot& state, mvec& state_moves);
+
+
+    /* ===========================================================================
+    **  Get the key of a hash in the tables, which is the hash itself unless
+    **  only canonical states are stored.
+    **
+    ** @param hash  the hash corresponding to a board state. 
+    **
+    ** @return the key to look the state up with.
+    ** =========================================================================== */
+    hash_t lookupKey(hash_t hash);
+
+
+    /* ===========================================================================
+    **  Look up the next best move from the moves stored for the input hash.
+    **  Used for boards too wide for a mask of legal moves.
+    **
+    ** @param hash  the hash corresponding to a board state. 
+    **
+    ** @return a pair of ints that represent the next best move.
+    ** =========================================================================== */
+    pii getStoredBestMove(hash_t hash);
+
+
     /* ===========================================================================
     **  Temp.
     ** =========================================================================== */
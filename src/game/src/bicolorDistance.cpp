@@ -0,0 +1,336 @@
+/* ================================================================================
+ * Copyright: (C) 2022, SIRRL Social and Intelligent Robotics Research Laboratory, 
+ *     University of Waterloo, All rights reserved.
+ * 
+ * Authors: 
+ *     Austin Kothig <austin.kothig@uwaterloo.ca>
+ * 
+ * CopyPolicy: Released under the terms of the MIT License. 
+ *     See the accompanying LICENSE file for details.
+ * ================================================================================
+ */
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+
+#include <bicolorDistance.hpp>
+
+
+static const ull         UNREACHED = ~0ULL;
+static const std::size_t NO_NODE   = ~(std::size_t)0;
+static const std::size_t NUM_PAIRS = 12;
+
+//-- Black on peg 0 and white on peg 1.
+static const std::size_t GOAL_PAIR = 1;
+
+
+//-- A move of one of the two disks of a size, as the placement after it
+//-- and the pegs moved from and to. The smaller disks have to be on the
+//-- third peg.
+struct PairMove {
+    std::size_t next;
+    std::size_t from;
+    std::size_t to;
+};
+
+
+//-- Placement of both disks of a size on a peg, with black on top if set.
+static std::size_t getStackedPair(std::size_t peg, bool black_top) {
+    return ( black_top ? peg * 4 : 9 + peg );
+}
+
+
+//-- Each move of a placement, at most 4, as a count and the moves.
+typedef std::pair<std::size_t, std::array<PairMove, 4>> PairMoves;
+
+static PairMoves findPairMoves(std::size_t pair) {
+
+    PairMoves moves;
+    moves.first = 0;
+
+    std::size_t black = ( pair < 9 ? pair / 3 : pair - 9 );
+    std::size_t white = ( pair < 9 ? pair % 3 : pair - 9 );
+    bool black_free = ( black != white || pair < 9 );
+    bool white_free = ( black != white || pair >= 9 );
+
+    for (std::size_t to = 0; to < 3; ++to) {
+        if (black_free && to != black) {
+            std::size_t next = ( to == white ? getStackedPair(to, true) : to * 3 + white );
+            moves.second[moves.first++] = { next, black, to };
+        }
+        if (white_free && to != white) {
+            std::size_t next = ( to == black ? getStackedPair(to, false) : black * 3 + to );
+            moves.second[moves.first++] = { next, white, to };
+        }
+    }
+
+    return moves;
+}
+
+
+//-- The moves of every placement, worked out once.
+static const PairMoves& getPairMoves(std::size_t pair) {
+
+    static const std::array<PairMoves, NUM_PAIRS> table = [] {
+        std::array<PairMoves, NUM_PAIRS> moves;
+        for (std::size_t pdx = 0; pdx < NUM_PAIRS; ++pdx) { moves[pdx] = findPairMoves(pdx); }
+        return moves;
+    }();
+
+    return table[pair];
+}
+
+
+BicolorDistance::BicolorDistance(std::size_t disks/*=3*/) {
+
+    this->_num_disk = disks;
+
+    //-- Nothing to move below the smallest size.
+    std::size_t levels = std::max<std::size_t>(disks, 1);
+    _tower.resize(levels);
+    _settle.resize(levels);
+    _tower[0][0].assign(1, 0);
+    _tower[0][1].assign(1, 0);
+    _settle[0].assign(3, 0);
+
+    Level level;
+    for (std::size_t size = 1; size < levels; ++size) {
+
+        std::size_t half  = 1ULL << (size - 1);
+        std::size_t count = 3 * half;
+
+        //-- Move a tower with white on top of every size away from peg 0,
+        //-- any other tower costs the same by swapping colors or pegs.
+        level.below.resize(count);
+        for (std::size_t tdx = 0; tdx < count; ++tdx) {
+            level.below[tdx] = _tower[size - 1][tdx >= half ? 1 : 0][tdx & (half - 1)];
+        }
+        this->searchLevel(size, getStackedPair(0, false), level);
+
+        for (std::size_t other = 0; other < 2; ++other) {
+            _tower[size][other].resize(half << 1);
+            for (std::size_t flips = 0; flips < (half << 1); ++flips) {
+                std::size_t pair = getStackedPair(other, flips & half);
+                _tower[size][other][flips] = level.dist[pair * count + other * half + (flips & (half - 1))];
+            }
+        }
+
+        //-- Moves are undone by moving back, so the moves from each tower to
+        //-- the goal are the moves from the goal to each tower.
+        level.below = _settle[size - 1];
+        this->searchLevel(size, GOAL_PAIR, level);
+        collect(size, level.dist, _settle[size]);
+    }
+}
+
+
+std::size_t BicolorDistance::getNumDisks() const {
+    return _num_disk;
+}
+
+
+ull BicolorDistance::getDistance(const BoardSnapshot& state, std::size_t sizes) const {
+
+    std::vector<Level> levels;
+    return this->searchState(state, sizes, levels);
+}
+
+
+bool BicolorDistance::getBestMove(const BoardSnapshot& state, std::size_t sizes, int& from, int& to,
+                                  ull* dist/*=nullptr*/) const {
+
+    std::vector<Level> levels;
+    ull reach = this->searchState(state, sizes, levels);
+    if (dist) { *dist = reach; }
+    if (reach == 0) { return false; }
+
+    //-- Work down from the largest size, towards either the goal of the
+    //-- sizes so far or a tower of them, until some pair has to move first.
+    bool        settle = true;
+    std::size_t target = 0;
+    for (std::size_t size = sizes; size > 0; --size) {
+
+        const Level& level = levels[size];
+        std::size_t  half  = 1ULL << (size - 1);
+        std::size_t  count = 3 * half;
+        std::size_t  node  = NO_NODE;
+
+        if (settle) {
+
+            //-- Leave the pair in place if the smaller disks settle as fast.
+            if (getPair(state, size) == GOAL_PAIR && levels[size - 1].reach == level.reach) { continue; }
+
+            for (std::size_t tdx = 0; tdx < count && node == NO_NODE; ++tdx) {
+                std::size_t goal = GOAL_PAIR * count + tdx;
+                if (level.dist[goal] == UNREACHED) { continue; }
+                if (level.dist[goal] + _settle[size - 1][tdx] == level.reach) { node = goal; }
+            }
+        } else {
+            std::size_t peg   = target >> size;
+            std::size_t flips = target & ((half << 1) - 1);
+            node = getStackedPair(peg, flips & half) * count + peg * half + (flips & (half - 1));
+        }
+        if (node == NO_NODE) { return false; }
+
+        //-- Follow the path back to the tower the smaller disks first make.
+        std::size_t after = NO_NODE;
+        while (level.pred[node] != NO_NODE) {
+            after = node;
+            node  = level.pred[node];
+        }
+
+        //-- Until they have made it, the first move is theirs.
+        std::size_t tower = node % count;
+        if (level.below[tower] > 0) {
+            settle = false;
+            target = tower;
+            continue;
+        }
+        if (after == NO_NODE) { return false; }
+
+        const PairMoves& moves = getPairMoves(node / count);
+        for (std::size_t mdx = 0; mdx < moves.first; ++mdx) {
+            if (moves.second[mdx].next != after / count) { continue; }
+            from = (int)moves.second[mdx].from;
+            to   = (int)moves.second[mdx].to;
+            return true;
+        }
+        return false;
+    }
+
+    return false;
+}
+
+
+ull BicolorDistance::searchState(const BoardSnapshot& state, std::size_t sizes, std::vector<Level>& levels) const {
+
+    //-- Moves to each tower of the sizes so far, and to their goal.
+    levels.resize(sizes + 1);
+    levels[0].below.assign(3, 0);
+    levels[0].reach = 0;
+
+    std::vector<ull> gathered(3, 0);
+    for (std::size_t size = 1; size <= sizes; ++size) {
+
+        Level&      level = levels[size];
+        std::size_t pair  = getPair(state, size);
+        std::size_t count = 3ULL << (size - 1);
+
+        level.below = gathered;
+        this->searchLevel(size, pair, level);
+
+        //-- Either the pair is already in place and never moves, or the
+        //-- smaller disks last stack up before settling.
+        level.reach = ( pair == GOAL_PAIR ? levels[size - 1].reach : UNREACHED );
+        for (std::size_t tdx = 0; tdx < count; ++tdx) {
+            if (level.dist[GOAL_PAIR * count + tdx] == UNREACHED) { continue; }
+            level.reach = std::min(level.reach, level.dist[GOAL_PAIR * count + tdx] + _settle[size - 1][tdx]);
+        }
+
+        if (size < sizes) { collect(size, level.dist, gathered); }
+    }
+
+    return levels[sizes].reach;
+}
+
+
+void BicolorDistance::searchLevel(std::size_t size, std::size_t pair, Level& level) const {
+
+    //-- A tower is its peg times 2^(size-1) plus the smaller sizes with
+    //-- black on top.
+    std::size_t half  = 1ULL << (size - 1);
+    std::size_t count = 3 * half;
+    const std::array<std::vector<ull>, 2>& tower = _tower[size - 1];
+
+    typedef std::pair<ull, std::size_t> entry;
+    std::priority_queue<entry, std::vector<entry>, std::greater<entry>> open;
+
+    //-- Tower costs are already the fewest moves between towers, so a tower
+    //-- move is only worth trying right after a move of the pair.
+    std::vector<bool> paired(NUM_PAIRS * count, false);
+
+    std::vector<ull>&         dist = level.dist;
+    std::vector<std::size_t>& pred = level.pred;
+    dist.assign(NUM_PAIRS * count, UNREACHED);
+    pred.assign(NUM_PAIRS * count, NO_NODE);
+    for (std::size_t tdx = 0; tdx < count; ++tdx) {
+        if (level.below[tdx] == UNREACHED) { continue; }
+        dist[pair * count + tdx] = level.below[tdx];
+        open.push(std::make_pair(level.below[tdx], pair * count + tdx));
+    }
+
+    while (!open.empty()) {
+
+        entry top = open.top();
+        open.pop();
+        if (top.first != dist[top.second]) { continue; }
+
+        std::size_t from  = top.second / count;
+        std::size_t tdx   = top.second % count;
+        std::size_t peg   = tdx >> (size - 1);
+        std::size_t flips = tdx & (half - 1);
+
+        //-- Move one of the pair, with the smaller disks out of the way.
+        const PairMoves& moves = getPairMoves(from);
+        for (std::size_t mdx = 0; mdx < moves.first; ++mdx) {
+            const PairMove& move = moves.second[mdx];
+            if (3 - move.from - move.to != peg) { continue; }
+            std::size_t node = move.next * count + tdx;
+            if (top.first + 1 < dist[node]) {
+                dist[node]   = top.first + 1;
+                pred[node]   = top.second;
+                paired[node] = true;
+                open.push(std::make_pair(dist[node], node));
+            }
+        }
+
+        //-- Or move the smaller disks to another tower.
+        if (!paired[top.second]) { continue; }
+        for (std::size_t pdx = 0; pdx < 3; ++pdx) {
+
+            const ull*  cost = tower[pdx != peg ? 1 : 0].data();
+            std::size_t base = from * count + pdx * half;
+            for (std::size_t ndx = 0; ndx < half; ++ndx) {
+                ull total = top.first + cost[ndx ^ flips];
+                if (total < dist[base + ndx]) {
+                    dist[base + ndx]   = total;
+                    pred[base + ndx]   = top.second;
+                    paired[base + ndx] = false;
+                    open.push(std::make_pair(total, base + ndx));
+                }
+            }
+        }
+    }
+}
+
+
+void BicolorDistance::collect(std::size_t size, const std::vector<ull>& dist, std::vector<ull>& gathered) {
+
+    //-- A tower of the size is the pair stacked on the tower of the sizes
+    //-- below it, on the same peg.
+    std::size_t half  = 1ULL << (size - 1);
+    std::size_t count = 3 * half;
+
+    gathered.resize(count << 1);
+    for (std::size_t peg = 0; peg < 3; ++peg) {
+        for (std::size_t flips = 0; flips < (half << 1); ++flips) {
+            std::size_t pair = getStackedPair(peg, flips & half);
+            gathered[peg * (half << 1) + flips] = dist[pair * count + peg * half + (flips & (half - 1))];
+        }
+    }
+}
+
+
+std::size_t BicolorDistance::getPair(const BoardSnapshot& state, std::size_t size) {
+
+    std::uint64_t disk = 1ULL << (size - 1);
+    std::size_t black = 0, white = 0;
+    for (std::size_t pdx = 0; pdx < 3; ++pdx) {
+        if (state.blacks[pdx] & disk) { black = pdx; }
+        if (state.whites[pdx] & disk) { white = pdx; }
+    }
+
+    if (black != white) { return black * 3 + white; }
+    return getStackedPair(black, state.order[black] & disk);
+}
@@ -10,14 +10,27 @@
  * ================================================================================
  */
 
+#include <algorithm>
+
 #include <board.hpp>
+#include <boardPlanes.hpp>
+#include <hashBatch.hpp>
 
 
 Board::Board(std::size_t pegs/*=3*/, std::size_t disks/*=3*/, bool isBicolor/*=false*/) :
     _num_peg(pegs), _num_disk(disks), _bicolor(isBicolor) {
     
-    this->_board_set = false;
+    this->_board_set   = false;
+    this->_state_stale = false;
     this->_state.clear();
+    this->_blacks.clear();
+    this->_whites.clear();
+    this->_order.clear();
+
+    this->_hash      = 0;
+    this->_goal_hash = 0;
+    this->_misplaced = 0;
+    this->updatePowers();
 }
 
 
@@ -35,9 +48,11 @@ bool Board::init() {
     //-- Allocate storage for the board.
     this->allocateNewBoard();
     
-    //-- Check bounds for number of pegs and disks.
-    if (_num_disk < 3 || _num_disk > 6) { return false; } //TODO: What is the upperbound for these w.r.t. 
-    if (_num_peg  < 3 || _num_peg  > 6) { return false; } //      the hash function and 64-bit ull?
+    //-- Check bounds for number of pegs and disks. Disks are limited by the
+    //-- width of the peg masks, and both by what a hash_t can hold.
+    if (_num_disk < 3 || _num_disk > 64) { return false; }
+    if (_num_peg  < 3)                   { return false; }
+    if (!this->hashFits())               { return false; }
 
     //-- Allocate the goal only once.
     _goal.clear();
@@ -49,19 +64,32 @@ bool Board::init() {
     //-- Init the board state to the default state.
     if (_bicolor) {
         for (std::size_t size = 0; size < _num_disk; ++size) {
-            _state[0].push_back(Disk(_num_disk - size, (size+1) % 2));
-            _state[1].push_back(Disk(_num_disk - size, (size+2) % 2));
+
+            //-- Colors alternate up both starting pegs, out of phase.
+            std::uint64_t disk = 1ULL << (_num_disk - size - 1);
+            ((size+1) % 2 ? _whites : _blacks)[0] |= disk;
+            ((size+2) % 2 ? _whites : _blacks)[1] |= disk;
 
             _goal[0].push_back(Disk(_num_disk - size, 0)); // Black.
             _goal[1].push_back(Disk(_num_disk - size, 1)); // White.
         }
     } else {
         for (std::size_t size = 0; size < _num_disk; ++size) {
-            _state[0].push_back(Disk(_num_disk - size));
-
             _goal[_num_peg-1].push_back(Disk(_num_disk - size));
         }
+
+        //-- Every disk starts on the first peg.
+        _blacks[0] = (~0ULL >> (64 - _num_disk));
     }
+    _state_stale = true;
+
+    //-- Drawings of the old settings are no longer any good.
+    this->updateGlyphs();
+
+    //-- Start tracking the hash and distance from the goal.
+    this->generateEncoding(_goal, _encoding);
+    _goal_hash = computeHash(_encoding);
+    this->refreshTracking();
 
     //-- Declare that the board has been initialized.
     _board_set = true;
@@ -72,75 +100,107 @@ bool Board::init() {
 
 void Board::setNumPegs(std::size_t pegs) {
     _board_set = false;
+    _glyphs.clear();
     _num_peg = pegs;
+    this->updatePowers();
     return;
 }
 
 
 void Board::setNumDisks(std::size_t disks) {
     _board_set = false;
+    _glyphs.clear();
     _num_disk = disks;
+    this->updatePowers();
     return;
 }
 
 
 void Board::setBicolor(bool isBicolor) {
     _board_set = false;
+    _glyphs.clear();
     _bicolor = isBicolor;
+    this->updatePowers();
     return;
 }
 
 
-bool Board::setFromHashableState(unsigned long long hash) {
-    
-    //-- Decode the state vec from the hash.
-    std::vector<std::size_t> encoding = generateEncoding(hash);
+bool Board::setFromHashableState(hash_t hash) {
 
-    //-- Allocate storage for the board.
-    this->allocateNewBoard();
+    if (!_bicolor) {
 
-    //-- For each disk size, choose to place a disk on each peg
-    //-- based on the values in the state vec.
-    for (std::size_t ddx = 0; ddx < _num_disk; ++ddx) {
-        
-        std::vector<std::size_t> placed((_bicolor ? 2 : 1), 0);
+        //-- First pass over the bits only checks that each disk size is
+        //-- placed exactly once, so the board is left untouched if the 
+        //-- hash is rejected.
+        hash_t        bits   = hash;
+        std::uint64_t placed = 0;
         for (std::size_t pdx = 0; pdx < _num_peg; ++pdx) {
-            
-            //-- Calculate the current pos in the vec.
-            std::size_t idx = ddx + (pdx * _num_disk);
-            
-            //-- If zero, no disk to be placed.
-            if (encoding[idx] == 0) { continue; }
+            for (std::size_t ddx = 0; ddx < _num_disk; ++ddx, bits >>= 1) {
+                
+                if ((bits & 1) == 0) { continue; }
 
-            //-- Get the size and color 
-            std::size_t disk_size  = (_num_disk - ddx);
-            std::size_t disk_color = (encoding[idx] - 1) % 2;
+                std::uint64_t disk = 1ULL << (_num_disk - ddx - 1);
+                if (placed & disk) { return false; }
+                placed |= disk;
+            }
+        }
 
-            //-- Push the disk onto the board, and increment the
-            //-- number of disks for this color placed.
-            _state[pdx].push_back(Disk(disk_size, disk_color));
-            placed[disk_color] += 1;
+        //-- Every disk has to be somewhere on the board.
+        if (placed != (~0ULL >> (64 - _num_disk))) { return false; }
 
-            //std::cout << _state[pdx][ _state[pdx].size()-1 ] << " ";
+        //-- Second pass writes the bits into the peg planes.
+        _blacks.assign(_num_peg, 0);
+        _whites.assign(_num_peg, 0);
+        _order.assign(_num_peg, 0);
+        for (std::size_t pdx = 0; pdx < _num_peg; ++pdx) {
+            for (std::size_t ddx = 0; ddx < _num_disk; ++ddx, hash >>= 1) {
+                if (hash & 1) { _blacks[pdx] |= 1ULL << (_num_disk - ddx - 1); }
+            }
+        }
 
-            //-- Check to see if this state holds a second disk.
-            if (encoding[idx] >= 3) {
-                std::size_t second_color = (disk_color + 1) % 2;
-                _state[pdx].push_back(Disk(disk_size, second_color));
-                placed[second_color] += 1;
+        _state_stale = true;
+        this->refreshTracking();
+        return _board_set = true;
+    }
+    
+    //-- Decode the state vec from the hash into the scratch space.
+    this->generateEncoding(hash, _encoding);
 
-                //std::cout << _state[pdx][ _state[pdx].size()-1 ] << " ";
-            }
+    //-- Check that every disk size has exactly one disk of each color
+    //-- before touching the board. Pairs (3 or 4) hold one of each.
+    for (std::size_t ddx = 0; ddx < _num_disk; ++ddx) {
+
+        std::size_t blacks = 0, whites = 0;
+        for (std::size_t pdx = 0; pdx < _num_peg; ++pdx) {
+            std::size_t digit = _encoding[ddx + (pdx * _num_disk)];
+            blacks += (digit == 1 || digit >= 3);
+            whites += (digit == 2 || digit >= 3);
         }
 
-        //-- Check to see if too many or too few disks were placed per color.
-        //-- If Mono, this will just be one check, if Bicolor it will be two.
-        for (std::size_t idx = 0; idx < placed.size(); ++idx) {
-            if (placed[idx] != 1) { return false; }
+        if (blacks != 1 || whites != 1) { return false; }
+    }
+
+    //-- Set each disk size's bit on the planes of the pegs it is on.
+    _blacks.assign(_num_peg, 0);
+    _whites.assign(_num_peg, 0);
+    _order.assign(_num_peg, 0);
+    for (std::size_t edx = 0; edx < _encoding.size(); ++edx) {
+
+        std::size_t   pdx  = edx / _num_disk;
+        std::uint64_t disk = 1ULL << (_num_disk - (edx % _num_disk) - 1);
+
+        switch (_encoding[edx]) {
+            case 1: _blacks[pdx] |= disk; break;
+            case 2: _whites[pdx] |= disk; break;
+            case 3: _blacks[pdx] |= disk; _whites[pdx] |= disk; break;
+            case 4: _blacks[pdx] |= disk; _whites[pdx] |= disk; _order[pdx] |= disk; break;
+            default: break;
         }
-        //std::cout << std::endl;
-    } 
-    //std::cout << std::endl;  
+    }
+    _state_stale = true;
+
+    //-- Pick up tracking from the new state.
+    this->refreshTracking();
 
     //-- Declare that the board has been initialized.
     return _board_set = true;
@@ -163,67 +223,375 @@ bool Board::getIsBicolor() {
 
 
 std::vector<std::vector<Disk>> Board::getRawState() {
-    return _state;
+    return this->viewRawState();
 }
 
 
 std::vector<std::vector<Disk>> Board::getRawGoal() {
+    return this->viewRawGoal();
+}
+
+
+const std::vector<std::vector<Disk>>& Board::viewRawState() {
+    this->syncRawState();
+    return _state;
+}
+
+
+const std::vector<std::vector<Disk>>& Board::viewRawGoal() {
     return _goal;
 }
 
 
 std::string Board::getShowableState() {
-    return drawBoard(_state);    
+
+    //-- Only a set board has a hash to cache the drawing by.
+    if (_board_set) {
+        auto it = _render_cache.find(_hash);
+        if (it != _render_cache.end()) { return it->second; }
+    }
+
+    this->syncRawState();
+    this->drawBoard(_state, _render);
+
+    if (_board_set) {
+        if (_render_cache.size() >= RENDER_CACHE_LIMIT) { _render_cache.clear(); }
+        _render_cache.emplace(_hash, _render);
+    }
+
+    return _render;
 }
 
 
 std::string Board::getShowableGoal() {
-    return drawBoard(_goal);    
+    if (_glyphs.empty() || _goal_render.empty()) { this->drawBoard(_goal, _goal_render); }
+    return _goal_render;
 }
 
 
-ull Board::getHashableState() {
-    
-    //-- Set up a vector that the hash can be computed from.
-    std::vector<std::size_t> encoding = generateEncoding(_state);
-
-   // <REMOVE>
-    //for (int idx = 0; idx < encoding.size(); ++idx) {
-    //    if ((idx % _num_disk) == 0) std::cout << "| ";
-    //    std::cout << encoding[idx] << " ";
-    //}
-    //std::cout << "|" << std::endl;
-    // <\REMOVE>
+hash_t Board::getHashableState() {
+    return _hash;
+}
+
 
-    //-- Compute and return the hash from the encoding.
-    return computeHash(encoding);
+hash_t Board::getHashableGoal() {
+    return _goal_hash;
 }
 
 
-ull Board::getHashableGoal() {
+bool Board::setFromRankedState(hash_t rank) {
+    if (rank >= getNumStates()) { return false; }
+    return setFromHashableState(rankToHash(rank));
+}
 
-    //-- Set up a vector that the hash can be computed from.
-    std::vector<std::size_t> encoding = generateEncoding(_goal);
-    
-   // <REMOVE>
-    //for (int idx = 0; idx < encoding.size(); ++idx) {
-    //    if ((idx % _num_disk) == 0) std::cout << "| ";
-    //    std::cout << encoding[idx] << " ";
-    //}
-    //std::cout << "|" << std::endl;
-    // <\REMOVE>
 
-    //-- Compute and return the hash from the encoding.
-    return computeHash(encoding);
+hash_t Board::getRankedState() {
+    return this->rankPlanes(_blacks, _whites, _order);
+}
+
+
+hash_t Board::getRankedState(const BoardSnapshot& snapshot) {
+    return this->rankPlanes(snapshot.blacks, snapshot.whites, snapshot.order);
+}
+
+
+bool Board::getSnapshotFromRank(hash_t rank, BoardSnapshot& snapshot) {
+
+    if (!_board_set || _num_peg > BoardSnapshot::MAX_PEGS) { return false; }
+    if (rank >= getNumStates())                             { return false; }
+
+    snapshot.blacks.fill(0);
+    snapshot.whites.fill(0);
+    snapshot.order.fill(0);
+
+    //-- Each disk size is one digit of the rank, as in rankToHash.
+    hash_t base = ( _bicolor ? (_num_peg * _num_peg) + _num_peg : _num_peg );
+    for (std::size_t ddx = 0; ddx < _num_disk; ++ddx) {
+
+        std::size_t   pos  = (std::size_t)(rank % base);
+        std::uint64_t disk = 1ULL << (_num_disk - ddx - 1);
+        rank /= base;
+
+        if (!_bicolor) {
+            snapshot.blacks[pos] |= disk;
+        } else if (pos >= _num_peg * _num_peg) {
+            pos -= _num_peg * _num_peg;
+            snapshot.blacks[pos] |= disk;
+            snapshot.whites[pos] |= disk;
+            snapshot.order[pos]  |= disk;
+        } else {
+            snapshot.blacks[pos / _num_peg] |= disk;
+            snapshot.whites[pos % _num_peg] |= disk;
+        }
+    }
+
+    this->trackPlanes(snapshot.blacks, snapshot.whites, snapshot.order, snapshot.hash, snapshot.misplaced);
+    return true;
+}
+
+
+template<typename Planes>
+hash_t Board::rankPlanes(const Planes& blacks, const Planes& whites, const Planes& order) {
+
+    hash_t base  = ( _bicolor ? (_num_peg * _num_peg) + _num_peg : _num_peg );
+    hash_t rank  = 0;
+    hash_t place = 1;
+    for (std::size_t ddx = 0; ddx < _num_disk; ++ddx, place *= base) {
+
+        //-- Find the peg of each color of this size.
+        std::uint64_t disk  = 1ULL << (_num_disk - ddx - 1);
+        std::size_t   black = 0, white = 0;
+        for (std::size_t pdx = 0; pdx < _num_peg; ++pdx) {
+            if (blacks[pdx] & disk) { black = pdx; }
+            if (whites[pdx] & disk) { white = pdx; }
+        }
+
+        if (!_bicolor) {
+            rank += black * place;
+        } else if (black == white && (order[black] & disk)) {
+            rank += ((_num_peg * _num_peg) + black) * place;
+        } else {
+            rank += ((black * _num_peg) + white) * place;
+        }
+    }
+
+    return rank;
+}
+
+
+hash_t Board::getNumStates() {
+
+    //-- Every disk size independently picks where its disk(s) go. In bicolor
+    //-- the two disks of a size are either on different pegs, or stacked on 
+    //-- the same peg in one of two orders.
+    hash_t base  = ( _bicolor ? (_num_peg * _num_peg) + _num_peg : _num_peg );
+    hash_t total = 1;
+    for (std::size_t ddx = 0; ddx < _num_disk; ++ddx) {
+        total *= base;
+    }
+
+    return total;
+}
+
+
+hash_t Board::rankToHash(hash_t rank) {
+
+    hash_t base = ( _bicolor ? (_num_peg * _num_peg) + _num_peg : _num_peg );
+    hash_t hash = 0;
+
+    //-- Each disk size is one base-(positions) digit of the rank.
+    for (std::size_t ddx = 0; ddx < _num_disk; ++ddx) {
+
+        hash_t pos = rank % base;
+        rank /= base;
+
+        if (!_bicolor) {
+            hash += _powers[ddx + (pos * _num_disk)];
+            continue;
+        }
+
+        //-- [0, pegs^2) holds the black and white pegs, where a shared peg 
+        //-- means black is on the bottom. [pegs^2, pegs^2 + pegs) means 
+        //-- white is on the bottom of that shared peg.
+        if (pos >= _num_peg * _num_peg) {
+            hash += 4 * _powers[ddx + ((pos - (_num_peg * _num_peg)) * _num_disk)];
+            continue;
+        }
+
+        std::size_t black = pos / _num_peg;
+        std::size_t white = pos % _num_peg;
+        if (black == white) {
+            hash += 3 * _powers[ddx + (black * _num_disk)];
+        } else {
+            hash += 1 * _powers[ddx + (black * _num_disk)];
+            hash += 2 * _powers[ddx + (white * _num_disk)];
+        }
+    }
+
+    return hash;
+}
+
+
+hash_t Board::hashToRank(hash_t hash) {
+
+    hash_t radix   = ( _bicolor ? 5 : 2 );
+    hash_t base    = ( _bicolor ? (_num_peg * _num_peg) + _num_peg : _num_peg );
+    hash_t invalid = getNumStates();
+
+    //-- Anything past the last slot cannot be a valid state.
+    if (hash / _powers.back() >= radix) { return invalid; }
+
+    hash_t rank  = 0;
+    hash_t place = 1;
+    for (std::size_t ddx = 0; ddx < _num_disk; ++ddx, place *= base) {
+
+        //-- Find where the disk(s) of this size are.
+        std::size_t black = _num_peg, white = _num_peg;
+        std::size_t found = 0;
+        hash_t pos = 0;
+        for (std::size_t pdx = 0; pdx < _num_peg; ++pdx) {
+
+            hash_t digit = (hash / _powers[ddx + (pdx * _num_disk)]) % radix;
+            if (digit == 0) { continue; }
+
+            found += 1;
+            if      (digit == 1) { black = pdx; }
+            else if (digit == 2) { white = pdx; }
+            else if (digit == 3) { black = white = pdx; }
+            else                 { black = white = pdx; pos = (_num_peg * _num_peg) + pdx; }
+        }
+
+        //-- Mono needs exactly one slot set, bicolor one slot per color.
+        if (!_bicolor) {
+            if (found != 1) { return invalid; }
+            rank += black * place;
+            continue;
+        }
+
+        if (black == _num_peg || white == _num_peg) { return invalid; }
+        if (found != (black == white ? 1 : 2))      { return invalid; }
+        if (pos == 0) { pos = (black * _num_peg) + white; }
+
+        rank += pos * place;
+    }
+
+    return rank;
+}
+
+
+bool Board::isGoal() {
+    return _board_set && _misplaced == 0;
+}
+
+
+std::size_t Board::getNumMisplaced() {
+    return _misplaced;
+}
+
+
+ull Board::getLowerBound() {
+    return this->boundPlanes(_blacks, _whites, _order);
+}
+
+
+ull Board::getLowerBound(const BoardSnapshot& snapshot) {
+    return this->boundPlanes(snapshot.blacks, snapshot.whites, snapshot.order);
+}
+
+
+bool Board::getClassicMove(int& from, int& to) {
+
+    if (!_board_set || _num_peg != 3 || _bicolor) { return false; }
+
+    std::size_t target = _num_peg - 1;
+    bool        found  = false;
+    for (std::size_t size = _num_disk; size > 0; --size) {
+
+        std::uint64_t disk = 1ULL << (size-1);
+        std::size_t   peg  = ( _blacks[0] & disk ? 0 : (_blacks[1] & disk ? 1 : 2) );
+        if (peg == target) { continue; }
+
+        //-- Every smaller disk is then on the third peg, so this one is free to move.
+        from   = (int)peg;
+        to     = (int)target;
+        found  = true;
+        target = 3 - peg - target;
+    }
+
+    return found;
+}
+
+
+template<typename Planes>
+ull Board::boundPlanes(const Planes& blacks, const Planes& whites, const Planes& order) {
+
+    const std::size_t goal = _num_peg - 1;
+    ull bound = 0;
+
+    if (!_bicolor) {
+
+        //-- Peg of every disk size.
+        std::size_t pegs[64];
+        for (std::size_t pdx = 0; pdx < _num_peg; ++pdx) {
+            for (std::uint64_t disks = blacks[pdx]; disks; disks &= disks - 1) {
+                pegs[__builtin_ctzll(disks)] = pdx;
+            }
+        }
+
+        //-- With 3 pegs, going from the largest disk down, a disk off the
+        //-- target needs the smaller disks moved to the third peg first, and 
+        //-- then moved back on top of it: 2^(size-1) moves in all.
+        if (_num_peg == 3) {
+            std::size_t target = goal;
+            for (std::size_t size = _num_disk; size > 0; --size) {
+                if (pegs[size-1] == target) { continue; }
+                bound += 1ULL << (size-1);
+                target = 3 - pegs[size-1] - target;
+            }
+            return bound;
+        }
+
+        //-- Else find the largest disk k off the goal peg. Larger disks are
+        //-- done, and smaller disks on k's peg or the goal peg have to step
+        //-- aside before k moves, then come back to the goal afterwards.
+        std::uint64_t misplaced = (~0ULL >> (64 - _num_disk)) & ~blacks[goal];
+        if (misplaced == 0) { return 0; }
+
+        std::size_t   k     = 63 - __builtin_clzll(misplaced);
+        std::uint64_t aside = (blacks[pegs[k]] | blacks[goal]) & ((1ULL << k) - 1);
+        return 1 + k + __builtin_popcountll(aside);
+    }
+
+    //-- Bicolor: sizes whose black or white disk is not on its goal peg.
+    const std::uint64_t all = (~0ULL >> (64 - _num_disk));
+    std::uint64_t black_missing = all & ~blacks[goalPeg(0)];
+    std::uint64_t white_missing = all & ~whites[goalPeg(1)];
+
+    for (std::size_t pdx = 0; pdx < _num_peg; ++pdx) {
+
+        //-- Walk the peg bottom to top, noting once anything off its goal is seen.
+        bool blocked = false;
+        for (std::size_t size = _num_disk; size > 0; --size) {
+
+            std::uint64_t disk  = 1ULL << (size - 1);
+            std::uint64_t above = ~((disk << 1) - 1);
+            bool          black = blacks[pdx] & disk;
+            bool          white = whites[pdx] & disk;
+
+            //-- Colors in bottom to top order, a pair with black on top is white first.
+            std::size_t colors[2], count = 0;
+            if (black && white && (order[pdx] & disk)) { colors[count++] = 1; colors[count++] = 0; }
+            else {
+                if (black) { colors[count++] = 0; }
+                if (white) { colors[count++] = 1; }
+            }
+
+            for (std::size_t cdx = 0; cdx < count; ++cdx) {
+                std::size_t color = colors[cdx];
+
+                //-- Off the goal peg it moves at least once. On the goal peg it
+                //-- still has to leave and come back if something below it has
+                //-- to leave, or a larger disk of its color has to go under it.
+                if (pdx != goalPeg(color)) {
+                    bound  += 1;
+                    blocked = true;
+                } else if (blocked || ((color ? white_missing : black_missing) & above)) {
+                    bound += 2;
+                }
+            }
+        }
+    }
+
+    return bound;
 }
 
 
-ull Board::computeHash(std::vector<std::size_t> encoding) {
+hash_t Board::computeHash(const std::vector<std::size_t>& encoding) {
 
     //-- Compute the hash of the board state.
-    ull hash = 0;
+    hash_t hash = 0;
 
-    ull power = 1;
+    hash_t power = 1;
     for (std::size_t edx = 0; edx < encoding.size(); ++edx) {
 
         // <REMOVE>
@@ -242,17 +610,31 @@ ull Board::computeHash(std::vector<std::size_t> encoding) {
 }
 
 
-std::vector<std::size_t> Board::generateEncoding(const std::vector<std::vector<Disk>> board) {
+std::vector<std::size_t> Board::generateEncoding(const std::vector<std::vector<Disk>>& board) {
+    std::vector<std::size_t> encoding;
+    this->generateEncoding(board, encoding);
+    return encoding;
+}
 
-    //-- Set up a vector to hold the converted hash.
-    std::vector<std::size_t> encoding(_num_peg * _num_disk);
+
+std::vector<std::size_t> Board::generateEncoding(hash_t hash) {
+    std::vector<std::size_t> encoding;
+    this->generateEncoding(hash, encoding);
+    return encoding;
+}
+
+
+void Board::generateEncoding(const std::vector<std::vector<Disk>>& board, std::vector<std::size_t>& encoding) {
+
+    //-- Reset the vector to hold the converted hash.
+    encoding.assign(_num_peg * _num_disk, 0);
 
     //-- Step through the board state and build a vector to hash.
     for (std::size_t pdx = 0; pdx < board.size(); ++pdx) {
         for (std::size_t ddx = 0; ddx < board[pdx].size(); ++ddx) {
             
-            //-- Get a copy of this disk.
-            Disk d = board[pdx][ddx];
+            //-- Look at this disk.
+            const Disk& d = board[pdx][ddx];
 
             //-- Compute the index of the encoding vector from the current disk.
             std::size_t edx = (_num_disk - d.getSize()) + (pdx * _num_disk);
@@ -274,7 +656,7 @@ std::vector<std::size_t> Board::generateEncoding(const std::vector<std::vector<D
                 if (ddx+1 < board[pdx].size()) {
 
                     //-- Get the disk above and check if the sizes are the same.
-                    Disk top = board[pdx][ddx+1];
+                    const Disk& top = board[pdx][ddx+1];
                     if (d.getSize() == top.getSize()) {
 
                         //-- Case 3/4: adjust state val.
@@ -298,14 +680,14 @@ std::vector<std::size_t> Board::generateEncoding(const std::vector<std::vector<D
         }
     }
 
-    return encoding;
+    return;
 }
 
 
-std::vector<std::size_t> Board::generateEncoding(ull hash) {
+void Board::generateEncoding(hash_t hash, std::vector<std::size_t>& encoding) {
 
-    //-- Set up a vector to hold the converted hash.
-    std::vector<std::size_t> encoding(_num_peg * _num_disk);
+    //-- Resize the vector to hold the converted hash.
+    encoding.resize(_num_peg * _num_disk);
 
     //-- Recover the encoding from the hash.
     for (std::size_t edx = 0; edx < encoding.size(); ++edx) {
@@ -315,7 +697,27 @@ std::vector<std::size_t> Board::generateEncoding(ull hash) {
 
     }
 
-    return encoding;
+    return;
+}
+
+
+void Board::computeHashes(const std::vector<std::size_t>& encodings, std::vector<hash_t>& hashes) {
+
+    std::size_t slots = _num_peg * _num_disk;
+    hashes.resize(encodings.size() / slots);
+    encodeHashes(encodings.data(), hashes.size(), slots, ( _bicolor ? 5 : 2 ), hashes.data());
+
+    return;
+}
+
+
+void Board::generateEncodings(const std::vector<hash_t>& hashes, std::vector<std::size_t>& encodings) {
+
+    std::size_t slots = _num_peg * _num_disk;
+    encodings.resize(hashes.size() * slots);
+    decodeHashes(hashes.data(), hashes.size(), slots, ( _bicolor ? 5 : 2 ), encodings.data());
+
+    return;
 }
 
 
@@ -324,25 +726,191 @@ bool Board::move(const int from, const int to) {
     // If the board state has not been set, return false.
     if (!_board_set) { return false; }
 
-    //-- Check if to and from are within range of our pegs.
-    if (from < 0 || from >= _num_peg) { return false; }
-    if (to   < 0 || to   >= _num_peg) { return false; }
-    
-    //-- Check if the from position has a disk to take.
-    if (_state[from].size() == 0) { return false; }
+    if (!planesMove(_blacks, _whites, _order, _hash, _misplaced, _num_peg, _num_disk, _bicolor, _powers, from, to)) { return false; }
+    _state_stale = true;
+
+    return true;
+}
+
 
-    //-- Check if the top disk of from can go onto the top disk of to.
-    Disk disk = _state[from].back();
-    if (_state[to].size() && disk > _state[to].back()) { return false; }
+bool Board::saveSnapshot(BoardSnapshot& snapshot) {
 
-    //-- Else everything is okay, make the move.
-    _state[from].pop_back();
-    _state[to].push_back(disk);
+    if (!_board_set || _num_peg > BoardSnapshot::MAX_PEGS) { return false; }
+
+    //-- Pegs past the last are left empty.
+    snapshot.blacks.fill(0);
+    snapshot.whites.fill(0);
+    snapshot.order.fill(0);
+    for (std::size_t pdx = 0; pdx < _num_peg; ++pdx) {
+        snapshot.blacks[pdx] = _blacks[pdx];
+        snapshot.whites[pdx] = _whites[pdx];
+        snapshot.order[pdx]  = _order[pdx];
+    }
+    snapshot.hash      = _hash;
+    snapshot.misplaced = _misplaced;
+
+    return true;
+}
+
+
+bool Board::loadSnapshot(const BoardSnapshot& snapshot) {
+
+    if (!_board_set || _num_peg > BoardSnapshot::MAX_PEGS) { return false; }
+
+    for (std::size_t pdx = 0; pdx < _num_peg; ++pdx) {
+        _blacks[pdx] = snapshot.blacks[pdx];
+        _whites[pdx] = snapshot.whites[pdx];
+        _order[pdx]  = snapshot.order[pdx];
+    }
+    _hash        = snapshot.hash;
+    _misplaced   = snapshot.misplaced;
+    _state_stale = true;
 
     return true;
 }
 
 
+bool Board::applyMove(const BoardSnapshot& snapshot, const int from, const int to, BoardSnapshot& next) {
+
+    next = snapshot;
+    if (!_board_set || _num_peg > BoardSnapshot::MAX_PEGS) { return false; }
+
+    return planesMove(next.blacks, next.whites, next.order, next.hash, next.misplaced, 
+                      _num_peg, _num_disk, _bicolor, _powers, from, to);
+}
+
+
+std::uint64_t Board::getLegalMoves() {
+    if (!_board_set || _num_peg > BoardSnapshot::MAX_PEGS) { return 0; }
+    return this->legalPlanes(_blacks, _whites);
+}
+
+
+std::uint64_t Board::getLegalMoves(const BoardSnapshot& snapshot) {
+    if (!_board_set || _num_peg > BoardSnapshot::MAX_PEGS) { return 0; }
+    return this->legalPlanes(snapshot.blacks, snapshot.whites);
+}
+
+
+std::size_t Board::getMoveIndex(const int from, const int to) {
+    return (from * (_num_peg - 1)) + (to < from ? to : to - 1);
+}
+
+
+void Board::getMoveFromIndex(std::size_t index, int& from, int& to) {
+    from = index / (_num_peg - 1);
+    to   = index % (_num_peg - 1);
+    if (to >= from) { to += 1; }
+    return;
+}
+
+
+template<typename Planes>
+std::uint64_t Board::legalPlanes(const Planes& blacks, const Planes& whites) {
+
+    //-- The top disk of each peg is the lowest bit of its planes.
+    std::uint64_t tops[BoardSnapshot::MAX_PEGS];
+    for (std::size_t pdx = 0; pdx < _num_peg; ++pdx) {
+        std::uint64_t occupied = blacks[pdx] | whites[pdx];
+        tops[pdx] = occupied & (~occupied + 1);
+    }
+
+    //-- A top disk can go on an empty peg, or one whose top is no smaller.
+    std::uint64_t mask = 0;
+    std::size_t   bit  = 0;
+    for (std::size_t from = 0; from < _num_peg; ++from) {
+        for (std::size_t to = 0; to < _num_peg; ++to) {
+            if (from == to) { continue; }
+            if (tops[from] && (tops[to] == 0 || tops[to] >= tops[from])) { mask |= 1ULL << bit; }
+            bit += 1;
+        }
+    }
+
+    return mask;
+}
+
+
+hash_t Board::getCanonicalState(std::vector<std::size_t>& pegs) {
+    return this->canonicalPlanes(_blacks, _whites, _order, pegs);
+}
+
+
+hash_t Board::getCanonicalState(const BoardSnapshot& snapshot, std::vector<std::size_t>& pegs) {
+    return this->canonicalPlanes(snapshot.blacks, snapshot.whites, snapshot.order, pegs);
+}
+
+
+template<typename Planes>
+hash_t Board::canonicalPlanes(const Planes& blacks, const Planes& whites, const Planes& order, 
+                              std::vector<std::size_t>& pegs) {
+
+    pegs.resize(_num_peg);
+    for (std::size_t pdx = 0; pdx < _num_peg; ++pdx) { pegs[pdx] = pdx; }
+
+    //-- Mono: sort every peg but the goal peg by its plane. Pegs holding
+    //-- the same disks are the same, so the order is unique.
+    if (!_bicolor) {
+        std::sort(pegs.begin(), pegs.end() - 1, [&](std::size_t lhs, std::size_t rhs) {
+            return blacks[lhs] < blacks[rhs];
+        });
+        return this->hashPlanes(blacks, whites, order, pegs, false);
+    }
+
+    //-- Bicolor: sort the free pegs by their planes, once as they are...
+    std::sort(pegs.begin() + 2, pegs.end(), [&](std::size_t lhs, std::size_t rhs) {
+        if (blacks[lhs] != blacks[rhs]) { return blacks[lhs] < blacks[rhs]; }
+        if (whites[lhs] != whites[rhs]) { return whites[lhs] < whites[rhs]; }
+        return order[lhs] < order[rhs];
+    });
+    hash_t hash = this->hashPlanes(blacks, whites, order, pegs, false);
+
+    //-- ...and once with the colors swapped, which also swaps pegs 0 and 1.
+    //-- A pair with black on top becomes a pair with white on top.
+    _symmetry.assign(pegs.begin(), pegs.end());
+    std::swap(_symmetry[0], _symmetry[1]);
+    std::sort(_symmetry.begin() + 2, _symmetry.end(), [&](std::size_t lhs, std::size_t rhs) {
+        if (whites[lhs] != whites[rhs]) { return whites[lhs] < whites[rhs]; }
+        if (blacks[lhs] != blacks[rhs]) { return blacks[lhs] < blacks[rhs]; }
+        std::uint64_t lhs_order = blacks[lhs] & whites[lhs] & ~order[lhs];
+        std::uint64_t rhs_order = blacks[rhs] & whites[rhs] & ~order[rhs];
+        return lhs_order < rhs_order;
+    });
+    hash_t swapped = this->hashPlanes(blacks, whites, order, _symmetry, true);
+
+    //-- The smaller of the two is the representative.
+    if (swapped < hash) {
+        pegs.swap(_symmetry);
+        return swapped;
+    }
+
+    return hash;
+}
+
+
+template<typename Planes>
+hash_t Board::hashPlanes(const Planes& blacks, const Planes& whites, const Planes& order, 
+                         const std::vector<std::size_t>& pegs, bool swapped) {
+
+    //-- Digits of each slot once the colors are swapped.
+    static const hash_t swap_digit[5] = { 0, 2, 1, 4, 3 };
+
+    hash_t hash = 0;
+    for (std::size_t pdx = 0; pdx < _num_peg; ++pdx) {
+
+        std::size_t   peg      = pegs[pdx];
+        std::uint64_t occupied = blacks[peg] | whites[peg];
+        while (occupied) {
+            std::size_t bit   = __builtin_ctzll(occupied);
+            hash_t      digit = planesSlotDigit(blacks, whites, order, peg, 1ULL << bit);
+            hash += ( swapped ? swap_digit[digit] : digit ) * _powers[(_num_disk - bit - 1) + (pdx * _num_disk)];
+            occupied &= occupied - 1;
+        }
+    }
+
+    return hash;
+}
+
+
 void Board::allocateNewBoard() {
 
     //-- Declare that the board is uninitialized.
@@ -357,11 +925,117 @@ void Board::allocateNewBoard() {
         _state[idx].reserve(_num_disk*2 + 1);
     }
 
+    //-- Empty every peg plane.
+    _blacks.assign(_num_peg, 0);
+    _whites.assign(_num_peg, 0);
+    _order.assign(_num_peg, 0);
+    _state_stale = false;
+
+    return;
+}
+
+
+void Board::updatePowers() {
+
+    _powers.resize(_num_peg * _num_disk);
+
+    hash_t power = 1;
+    for (std::size_t edx = 0; edx < _powers.size(); ++edx) {
+        _powers[edx] = power;
+        power *= ( _bicolor ? 5 : 2 );
+    }
+
+    return;
+}
+
+
+void Board::refreshTracking() {
+    this->trackPlanes(_blacks, _whites, _order, _hash, _misplaced);
+    return;
+}
+
+
+template<typename Planes>
+void Board::trackPlanes(const Planes& blacks, const Planes& whites, const Planes& order, 
+                        hash_t& hash, std::size_t& misplaced) {
+
+    //-- Add up the digit of every occupied slot.
+    hash = 0;
+    for (std::size_t pdx = 0; pdx < _num_peg; ++pdx) {
+        std::uint64_t occupied = blacks[pdx] | whites[pdx];
+        while (occupied) {
+            std::size_t bit = __builtin_ctzll(occupied);
+            hash += planesSlotDigit(blacks, whites, order, pdx, 1ULL << bit) * _powers[(_num_disk - bit - 1) + (pdx * _num_disk)];
+            occupied &= occupied - 1;
+        }
+    }
+
+    //-- Count every disk not on the goal peg of its color.
+    misplaced = _num_disk - __builtin_popcountll(blacks[goalPeg(0)]);
+    if (_bicolor) {
+        misplaced += _num_disk - __builtin_popcountll(whites[goalPeg(1)]);
+    }
+
+    return;
+}
+
+
+bool Board::hashFits() {
+
+    //-- Build up the largest possible hash, radix^(pegs*disks) - 1, one 
+    //-- slot at a time and stop if the next slot would overflow.
+    const hash_t limit = ~((hash_t)0);
+    const hash_t radix = ( _bicolor ? 5 : 2 );
+
+    hash_t largest = 0;
+    for (std::size_t edx = 0; edx < _num_peg * _num_disk; ++edx) {
+        if (largest > (limit - (radix - 1)) / radix) { return false; }
+        largest = (largest * radix) + (radix - 1);
+    }
+
+    return true;
+}
+
+
+std::size_t Board::goalPeg(std::size_t color) {
+    //-- Mono disks all go to the last peg, bicolor goes black:0 and white:1.
+    return ( _bicolor ? color : _num_peg-1 );
+}
+
+
+void Board::syncRawState() {
+
+    if (!_state_stale) { return; }
+    _state.resize(_num_peg);
+
+    //-- Walk each peg from the largest disk to the smallest, which is
+    //-- bottom to top of the peg. Capacity was reserved on allocation.
+    for (std::size_t pdx = 0; pdx < _num_peg; ++pdx) {
+        _state[pdx].clear();
+        for (std::size_t size = _num_disk; size > 0; --size) {
+
+            std::uint64_t disk  = 1ULL << (size - 1);
+            bool          black = _blacks[pdx] & disk;
+            bool          white = _whites[pdx] & disk;
+
+            if (black && white) {
+                bool black_top = _order[pdx] & disk;
+                _state[pdx].push_back(Disk(size, black_top ? 1 : 0));
+                _state[pdx].push_back(Disk(size, black_top ? 0 : 1));
+            } else if (black) {
+                _state[pdx].push_back(Disk(size, 0));
+            } else if (white) {
+                _state[pdx].push_back(Disk(size, 1));
+            }
+        }
+    }
+
+    _state_stale = false;
     return;
 }
 
 
-std::string Board::drawBoard(const std::vector<std::vector<Disk>> board) {
+void Board::updateGlyphs() {
 
     //-- Set some aliases for the ascii characters.
     const std::string peg   = "\u2502";
@@ -370,35 +1044,48 @@ std::string Board::drawBoard(const std::vector<std::vector<Disk>> board) {
     const std::string white = "\u2591";
     const std::string btwn  = "  ";
 
-    //-- Init the return string.
-    std::string ret = "";
+    //-- One glyph per color for every size, padded to the width of a peg.
+    _glyphs.assign(2 * (_num_disk + 1), "");
+    for (std::size_t color = 0; color < 2; ++color) {
+
+        _glyphs[color * (_num_disk + 1)] = std::string(_num_disk, ' ') + peg + std::string(_num_disk, ' ');
+        for (std::size_t size = 1; size <= _num_disk; ++size) {
+            std::string& glyph = _glyphs[(color * (_num_disk + 1)) + size];
+            glyph  = std::string(_num_disk - size, ' ');
+            glyph += repeatString((color ? white : black), (size*2) + 1);
+            glyph += std::string(_num_disk - size, ' ');
+        }
+    }
 
-    //-- Use some buffer for a single line.
-    std::string line = "";
-    
     //-- Width of a line.
     int line_width = 1 + btwn.length() + (((_num_disk * 2) + 1 + btwn.length()) * _num_peg);
-    line += repeatString(" ", line_width);// + "\n";
-    
+
+    //-- Add a line for the base of the game board.
+    _base_row = " " + repeatString(base, line_width-2) + "\n";
+
     //-- Set the position indicators.
+    _label_row = repeatString(" ", line_width);
     int idx = 1;
     for (int pdx = 0; pdx < _num_peg; ++pdx) {
         idx += btwn.length() + _num_disk;
         
-        line[idx-1] = '[';
-        line[idx]   = '0'+pdx;
-        line[idx+1] = ']';
+        _label_row[idx-1] = '[';
+        _label_row[idx]   = '0'+pdx;
+        _label_row[idx+1] = ']';
 
         idx += 1 + _num_disk;
     }
 
-    //-- Append the first line.
-    ret = line + ret;
+    _goal_render.clear();
+    _render_cache.clear();
 
-    //-- Add a line for the base of the game board.
-    line = " ";
-    line += repeatString(base, line_width-2) + "\n";
-    ret = line + ret;
+    return;
+}
+
+
+void Board::drawBoard(const std::vector<std::vector<Disk>>& board, std::string& out) {
+
+    if (_glyphs.empty()) { this->updateGlyphs(); }
 
     //-- Find the max height of a single peg.
     std::size_t max_height = 0;
@@ -407,45 +1094,44 @@ std::string Board::drawBoard(const std::vector<std::vector<Disk>> board) {
     }
     max_height += 1;
 
+    //-- Each glyph takes at most 3 bytes per character.
+    std::size_t row_bytes = 2 + (_num_peg * (2 + (3 * ((_num_disk * 2) + 1))));
+    out.clear();
+    out.reserve((max_height * row_bytes) + _base_row.size() + _label_row.size() + 2);
 
-    //-- Step through each height 
-    for (std::size_t hdx = 0; hdx < max_height; ++hdx) {
+    //-- Write from the top row down to the base, then the position indicators.
+    out += '\n';
+    for (std::size_t hdx = max_height; hdx-- > 0; ) {
 
-        //-- Clear the buffer an init the first space.
-        line = " ";
+        out += ' ';
         for (std::size_t pdx = 0; pdx < _num_peg; ++pdx) {
 
             //-- Add some space between pegs.
-            line += btwn;
+            out += "  ";
 
             //-- Empty position case.
             if (board[pdx].size() <= hdx) {
-                line += std::string(_num_disk, ' ') + peg + std::string(_num_disk, ' ');
+                out += _glyphs[0];
             } else {
-                Disk d = board[pdx][hdx];
-                line += std::string(_num_disk - d.getSize(), ' ');
-                line += repeatString((d.getColor() ? white : black), (d.getSize()*2) + 1);
-                line += std::string(_num_disk - d.getSize(), ' ');
+                const Disk& d = board[pdx][hdx];
+                out += _glyphs[(d.getColor() * (_num_disk + 1)) + d.getSize()];
             }
         }
-
-        //-- Add this row to the return buffer.
-        ret = line + "\n" + ret;
+        out += '\n';
     }
 
+    out += _base_row;
+    out += _label_row;
+    out += '\n';
 
-    ret = "\n" + ret + "\n";
-    //std::cout << ret << std::endl;
-    //std::cout << "01234567890123456789012345678901234567890" << std::endl;
-    //std::cout << "0         1         2         3         4" << std::endl;
-    
-    return ret;
+    return;
 }
 
 
 std::string Board::repeatString(const std::string& str, int n) {
-    std::ostringstream os;
-    while (n--)
-        os << str;
-    return os.str();
+    std::string ret;
+    ret.reserve(str.size() * (n > 0 ? n : 0));
+    while (n-- > 0)
+        ret += str;
+    return ret;
 }
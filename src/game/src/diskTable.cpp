@@ -0,0 +1,257 @@
+/* ================================================================================
+ * Copyright: (C) 2022, SIRRL Social and Intelligent Robotics Research Laboratory, 
+ *     University of Waterloo, All rights reserved.
+ * 
+ * Authors: 
+ *     Austin Kothig <austin.kothig@uwaterloo.ca>
+ * 
+ * CopyPolicy: Released under the terms of the MIT License. 
+ *     See the accompanying LICENSE file for details.
+ * ================================================================================
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <set>
+
+#include <unistd.h>
+
+#include <diskTable.hpp>
+
+
+static const std::uint32_t DISK_UNREACHED = UINT32_MAX;
+
+//-- Most files merged at once, which bounds the open files and read buffers.
+static const std::size_t MERGE_FANIN = 64;
+
+
+//-- Files made by a build that are removed once it returns, however it
+//-- returns, unless kept.
+class BuildFiles {
+    std::set<std::string> _paths;
+
+    public:
+    ~BuildFiles() { for (const std::string& path : _paths) { std::remove(path.c_str()); } }
+
+    const std::string& add(const std::string& path) { return *_paths.insert(path).first; }
+    void keep(const std::string& path)              { _paths.erase(path); }
+};
+
+
+//-- Reads the sorted ranks of a file back one at a time.
+struct RankReader {
+    std::ifstream file;
+    hash_t        value;
+    bool          valid;
+
+    RankReader(const std::string& path) : file(path, std::ios::binary), value(0), valid(true) { this->next(); }
+    bool next() { valid = (bool)file.read((char*)&value, sizeof(value)); return valid; }
+};
+
+
+//-- Sort and deduplicate ranks, write them to a file, and empty the buffer.
+static bool writeRun(std::vector<hash_t>& ranks, const std::string& path) {
+
+    std::sort(ranks.begin(), ranks.end());
+    ranks.erase(std::unique(ranks.begin(), ranks.end()), ranks.end());
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write((const char*)ranks.data(), ranks.size() * sizeof(hash_t));
+    ranks.clear();
+
+    return (bool)file;
+}
+
+
+//-- Merge sorted files into one without duplicates, leaving out every
+//-- rank found in the sorted exclude files.
+static bool mergeRuns(const std::vector<std::string>& inputs, const std::vector<std::string>& excludes,
+                      const std::string& output, hash_t& count) {
+
+    std::vector<std::unique_ptr<RankReader>> readers, skips;
+    for (const std::string& path : inputs)   { readers.emplace_back(new RankReader(path)); }
+    for (const std::string& path : excludes) { skips.emplace_back(new RankReader(path));   }
+
+    typedef std::pair<hash_t,std::size_t> head;
+    std::priority_queue<head, std::vector<head>, std::greater<head>> heap;
+    for (std::size_t rdx = 0; rdx < readers.size(); ++rdx) {
+        if (readers[rdx]->valid) { heap.push(std::make_pair(readers[rdx]->value, rdx)); }
+    }
+
+    std::ofstream file(output, std::ios::binary | std::ios::trunc);
+    bool   first = true;
+    hash_t last  = 0;
+    count = 0;
+    while (!heap.empty()) {
+
+        hash_t      value = heap.top().first;
+        std::size_t rdx   = heap.top().second;
+        heap.pop();
+        if (readers[rdx]->next()) { heap.push(std::make_pair(readers[rdx]->value, rdx)); }
+
+        if (!first && value == last) { continue; }
+        first = false;
+        last  = value;
+
+        //-- The excludes are walked forward alongside the output.
+        bool skip = false;
+        for (auto& reader : skips) {
+            while (reader->valid && reader->value < value) { reader->next(); }
+            if (reader->valid && reader->value == value) { skip = true; }
+        }
+        if (skip) { continue; }
+
+        file.write((const char*)&value, sizeof(value));
+        count += 1;
+    }
+
+    return (bool)file;
+}
+
+
+DiskTable::DiskTable(const std::string& directory/*="."*/, std::size_t buffer/*=1<<22*/) {
+    this->_directory = directory;
+    this->_name      = "";
+    this->_buffer    = std::max<std::size_t>(buffer, 1);
+    this->_states    = 0;
+    this->_reached   = 0;
+}
+
+
+DiskTable::~DiskTable() {
+    if (_table.is_open()) { _table.close(); }
+}
+
+
+bool DiskTable::build(Board& board) {
+
+    if (_table.is_open()) { _table.close(); }
+    _name = "toh_" + std::to_string(board.getNumPegs()) + "p_" + std::to_string(board.getNumDisks()) + "d_" +
+        ( board.getIsBicolor() ? "bicolor" : "mono" );
+    _states  = board.getNumStates();
+    _reached = 0;
+
+    BoardSnapshot goal;
+    if (!board.setFromHashableState(board.getHashableGoal()) || !board.saveSnapshot(goal)) { return false; }
+
+    //-- A build that fails leaves neither search files nor a partial table.
+    BuildFiles files;
+
+    //-- Start with every rank unreached, a buffer at a time.
+    std::fstream table(files.add(this->getTablePath()), std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+    {
+        std::vector<std::uint32_t> fill((std::size_t)std::min<hash_t>(_states, _buffer), DISK_UNREACHED);
+        for (hash_t done = 0; done < _states; done += fill.size()) {
+            std::size_t part = (std::size_t)std::min<hash_t>(fill.size(), _states - done);
+            table.write((const char*)fill.data(), part * sizeof(std::uint32_t));
+        }
+    }
+
+    std::vector<hash_t> ranks;
+    ranks.reserve(_buffer);
+    ranks.push_back(board.getRankedState(goal));
+    if (!writeRun(ranks, files.add(this->getPath("layer", 0)))) { return false; }
+
+    BoardSnapshot cur, next;
+    for (std::uint32_t dist = 0; ; ++dist) {
+
+        //-- Record the layer, and gather its successors into sorted runs.
+        std::vector<std::string> runs;
+        for (RankReader layer(this->getPath("layer", dist)); layer.valid; layer.next()) {
+
+            table.seekp((std::streamoff)(layer.value * sizeof(std::uint32_t)));
+            table.write((const char*)&dist, sizeof(dist));
+            _reached += 1;
+
+            board.getSnapshotFromRank(layer.value, cur);
+            for (std::uint64_t legal = board.getLegalMoves(cur); legal; legal &= legal - 1) {
+
+                int from, to;
+                board.getMoveFromIndex(__builtin_ctzll(legal), from, to);
+                board.applyMove(cur, from, to, next);
+                ranks.push_back(board.getRankedState(next));
+
+                if (ranks.size() < _buffer) { continue; }
+                runs.push_back(files.add(this->getPath("run", runs.size())));
+                if (!writeRun(ranks, runs.back())) { return false; }
+            }
+        }
+        if (!ranks.empty()) {
+            runs.push_back(files.add(this->getPath("run", runs.size())));
+            if (!writeRun(ranks, runs.back())) { return false; }
+        }
+
+        //-- Merge down to few enough runs to open at once.
+        hash_t count;
+        std::size_t pass = 0;
+        while (runs.size() > MERGE_FANIN) {
+            std::vector<std::string> merged;
+            for (std::size_t rdx = 0; rdx < runs.size(); rdx += MERGE_FANIN) {
+                std::vector<std::string> group(runs.begin() + rdx, runs.begin() + std::min(rdx + MERGE_FANIN, runs.size()));
+                merged.push_back(files.add(this->getPath("pass" + std::to_string(pass % 2) + "_run", merged.size())));
+                if (!mergeRuns(group, std::vector<std::string>(), merged.back(), count)) { return false; }
+            }
+            for (const std::string& run : runs) { std::remove(run.c_str()); }
+            runs.swap(merged);
+            pass += 1;
+        }
+
+        //-- Successors not in this layer or the one before make the next.
+        std::vector<std::string> excludes(1, this->getPath("layer", dist));
+        if (dist > 0) { excludes.push_back(this->getPath("layer", dist - 1)); }
+        if (!mergeRuns(runs, excludes, files.add(this->getPath("layer", dist + 1)), count)) { return false; }
+
+        for (const std::string& run : runs) { std::remove(run.c_str()); }
+        if (dist > 0) { std::remove(this->getPath("layer", dist - 1).c_str()); }
+
+        if (count == 0) {
+            std::remove(this->getPath("layer", dist).c_str());
+            std::remove(this->getPath("layer", dist + 1).c_str());
+            break;
+        }
+    }
+
+    table.close();
+    if (!table) { return false; }
+    files.keep(this->getTablePath());
+
+    _table.open(this->getTablePath(), std::ios::binary);
+    return _table.is_open();
+}
+
+
+bool DiskTable::lookup(hash_t rank, ull& dist) {
+
+    if (!_table.is_open() || rank >= _states) { return false; }
+
+    std::uint32_t entry = DISK_UNREACHED;
+    _table.clear();
+    _table.seekg((std::streamoff)(rank * sizeof(std::uint32_t)));
+    _table.read((char*)&entry, sizeof(entry));
+
+    dist = entry;
+    return _table && entry != DISK_UNREACHED;
+}
+
+
+hash_t DiskTable::getNumStates() {
+    return _states;
+}
+
+
+hash_t DiskTable::getNumReached() {
+    return _reached;
+}
+
+
+std::string DiskTable::getTablePath() {
+    return _directory + "/" + _name + "_table.bin";
+}
+
+
+std::string DiskTable::getPath(const std::string& kind, std::size_t index) {
+    return _directory + "/" + _name + "_" + std::to_string(getpid()) + "_" + kind + std::to_string(index) + ".bin";
+}
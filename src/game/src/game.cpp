@@ -18,10 +18,14 @@ Game::Game(std::shared_ptr<Player> player) {
     this->_player = player;
     this->_board  = std::make_shared<Board>();
     this->_solver = std::make_shared<Solver>();
+    this->_solve_timeout = std::chrono::milliseconds(0);
 }
 
 
 Game::~Game() {
+    //-- Let a background solve finish before its solver goes.
+    if (_solving.valid()) { _solving.wait(); }
+
     //-- Release the shared_ptr resource.
     this->_player.reset();
     this->_board.reset();
@@ -31,36 +35,108 @@ Game::~Game() {
 
 
 bool Game::configure(std::map<std::string,std::string> conf) {
-    //TODO: take strings from conf and set appropriately.
 
-    _board->setNumPegs(3);
-    _board->setNumDisks(4);
-    _board->setBicolor(true);
+    //-- Board settings, defaulting to the 3 peg, 4 disk bicolor game.
+    std::size_t pegs    = getConfValue(conf, "pegs",    3);
+    std::size_t disks   = getConfValue(conf, "disks",   4);
+    bool        bicolor = getConfValue(conf, "bicolor", 1) != 0;
+
+    //-- Optionally store only one of every set of symmetric states, or only
+    //-- a flat array of distances (storage: 0 map, 1 flat, 2 flat on disk).
+    solverOptions options;
+    options.symmetry = getConfValue(conf, "symmetry", 0) != 0;
+    std::size_t storage = getConfValue(conf, "storage", 0);
+    if (storage == 1) { options.storage = solverOptions::FLAT; }
+    if (storage == 2) { options.storage = solverOptions::DISK; }
+    options.disk_buffer = getConfValue(conf, "disk_buffer", options.disk_buffer);
+    if (conf.find("disk_path") != conf.end()) { options.disk_path = conf["disk_path"]; }
+    options.threads = getConfValue(conf, "threads", 1);
+
+    //-- Search everything up front (algorithm: 0), or one query at a time 
+    //-- with A* (1), with IDA* over pattern databases (2), or with a
+    //-- bidirectional breadth-first search (3). 3 peg games can also be
+    //-- answered without a search (4).
+    std::size_t algorithm = getConfValue(conf, "algorithm", 0);
+    if (algorithm == 1) { options.search = solverOptions::ASTAR;         }
+    if (algorithm == 2) { options.search = solverOptions::IDASTAR;       }
+    if (algorithm == 3) { options.search = solverOptions::BIDIRECTIONAL; }
+    if (algorithm == 4) { options.search = solverOptions::ANALYTIC;      }
+    options.max_nodes = getConfValue(conf, "max_nodes", 0);
+    options.local_depth  = getConfValue(conf, "local_depth",  0);
+    options.local_states = getConfValue(conf, "local_states", 0);
+    options.pdb_disks = getConfValue(conf, "pdb_disks", 0);
+    if (conf.find("pdb_path") != conf.end()) { options.pdb_path = conf["pdb_path"]; }
+
+    //-- Precomputed tables are mapped from, or saved to, this directory.
+    if (conf.find("table_path") != conf.end()) { options.table_path = conf["table_path"]; }
+
+    //-- Or shared with other processes of the host with the same settings.
+    options.shared = getConfValue(conf, "shared", 0) != 0;
+
+    //-- Solve in the background unless asked not to (background: 0), and
+    //-- have hint and dist wait this many milliseconds for it.
+    bool background = getConfValue(conf, "background", 1) != 0;
+    _solve_timeout  = std::chrono::milliseconds(getConfValue(conf, "solve_timeout", 0));
+
+    _board->setNumPegs(pegs);
+    _board->setNumDisks(disks);
+    _board->setBicolor(bicolor);
+
+    if (!_board->init()) {
+        std::cerr << "[error] Could not initialize a board with " << pegs << " pegs and " 
+                  << disks << " disks!" << std::endl;
+        return false;
+    }
+
+    //-- A solve from an earlier configuration has to finish first.
+    if (_solving.valid()) { _solving.wait(); }
 
-    _board->init();
+    //-- The solver searches with a compile time board for these settings if one exists.
+    std::shared_ptr<Solver> solver = std::make_shared<Solver>(pegs, disks, bicolor, options);
+    auto solve = [solver]() {
 
-    // Start a timer.
-    auto start = std::chrono::high_resolution_clock::now();
+        // Start a timer.
+        auto start = std::chrono::high_resolution_clock::now();
 
-    _solver.reset(new Solver(3, 4, true));
-    _solver->solve();
+        solver->solve();
 
-    // End the timer.
-    auto end = std::chrono::high_resolution_clock::now();
+        // End the timer.
+        auto end = std::chrono::high_resolution_clock::now();
 
-    std::cout << "Took "
-         << ((float)std::chrono::duration_cast<std::chrono::milliseconds>(end-start).count()) / 1000.0
-         << " seconds to run the solve function." << std::endl;
+        std::cout << "Took "
+             << ((float)std::chrono::duration_cast<std::chrono::milliseconds>(end-start).count()) / 1000.0
+             << " seconds to run the solve function." << std::endl;
+    };
+
+    //-- The game loop only hands the solver queries once the solve is done.
+    _solver = solver;
+    if (background) {
+        _solving = std::async(std::launch::async, solve).share();
+    } else {
+        solve();
+        _solving = std::shared_future<void>();
+    }
 
     return true;
 }
 
 
+const std::vector<std::string>& Game::getConfKeys() {
+
+    static const std::vector<std::string> keys = {
+        "pegs", "disks", "bicolor", "symmetry", "storage", "disk_buffer", "disk_path",
+        "threads", "algorithm", "max_nodes", "local_depth", "local_states", "pdb_disks",
+        "pdb_path", "table_path", "shared", "background", "solve_timeout"
+    };
+
+    return keys;
+}
+
+
 int Game::run() {
 
     //-- Set the running status of the game.
     _running = true;
-    ull goal_hash = _board->getHashableGoal();
 
     //-- Loop until interrupt occurs.
     while (_running) {
@@ -71,7 +147,7 @@ int Game::run() {
         //-- Set vars outside switch.
         bool success;
         std::string showable;
-        ull hash; pii hint;
+        hash_t hash; pii hint;
 
         switch (act.selection) {
         
@@ -90,8 +166,7 @@ int Game::run() {
             if (success) {
                 //-- If the move was good and we're at the goal state
                 //-- give notice and close the program.
-                hash = _board->getHashableState();
-                if (hash == goal_hash) {
+                if (_board->isGoal()) {
                     _player->writeOutput("2");
                     //_running = false;
                     break;
@@ -121,6 +196,10 @@ int Game::run() {
 
         case action::HINT:
             //-- Ask the solver for the next optimal move. 
+            if (!this->waitForSolver()) {
+                _player->writeOutput("not ready");
+                break;
+            }
             hash = _board->getHashableState();
             hint = _solver->getBestMove(hash);
             showable = std::to_string(hint.first) + " " + std::to_string(hint.second);
@@ -130,12 +209,16 @@ int Game::run() {
         case action::HASH:
             //-- Get the hash from the board and send it.
             hash = _board->getHashableState();
-            showable = std::to_string(hash);
+            showable = hashToString(hash);
             _player->writeOutput(showable);
             break;
 
         case action::DIST:
             //-- Get the distance to the goal from the solver for the current state.
+            if (!this->waitForSolver()) {
+                _player->writeOutput("not ready");
+                break;
+            }
             hash = _board->getHashableState();
             showable = std::to_string(_solver->getDistance(hash));
             _player->writeOutput(showable);
@@ -168,3 +251,27 @@ int Game::run() {
 
     return 0;
 }
+
+
+bool Game::waitForSolver() {
+
+    //-- Nothing to wait on if the solve ran in the foreground.
+    if (!_solving.valid()) { return true; }
+
+    return _solving.wait_for(_solve_timeout) == std::future_status::ready;
+}
+
+
+std::size_t Game::getConfValue(std::map<std::string,std::string>& conf, const std::string& key, std::size_t fallback) {
+
+    //-- Use the fallback if the key is missing or not a plain unsigned integer.
+    auto it = conf.find(key);
+    if (it == conf.end() || it->second.empty()) { return fallback; }
+    if (it->second.find_first_not_of("0123456789") != std::string::npos) { return fallback; }
+
+    try {
+        return std::stoul(it->second);
+    } catch(const std::out_of_range&) {
+        return fallback;
+    }
+}
@@ -0,0 +1,224 @@
+/* ================================================================================
+ * Copyright: (C) 2022, SIRRL Social and Intelligent Robotics Research Laboratory, 
+ *     University of Waterloo, All rights reserved.
+ * 
+ * Authors: 
+ *     Austin Kothig <austin.kothig@uwaterloo.ca>
+ * 
+ * CopyPolicy: Released under the terms of the MIT License. 
+ *     See the accompanying LICENSE file for details.
+ * ================================================================================
+ */
+
+#include <hashBatch.hpp>
+
+//-- The vector kernels work on 64 bit lanes, so are left out for wide hashes.
+#if defined(__GNUC__) && defined(__x86_64__) && !defined(TOWER_OF_HANOI_WIDE_HASH)
+#define TOWER_OF_HANOI_BATCH_AVX2
+#include <immintrin.h>
+#endif
+
+
+static void encodeScalar(const std::size_t* encodings, std::size_t count, std::size_t slots,
+                         std::size_t radix, hash_t* hashes) {
+
+    //-- Horner's rule from the highest slot down.
+    for (std::size_t sdx = 0; sdx < count; ++sdx) {
+        const std::size_t* digits = encodings + (sdx * slots);
+
+        hash_t hash = 0;
+        for (std::size_t edx = slots; edx > 0; --edx) {
+            hash = (hash * radix) + digits[edx-1];
+        }
+        hashes[sdx] = hash;
+    }
+
+    return;
+}
+
+
+static void decodeScalar(const hash_t* hashes, std::size_t count, std::size_t slots,
+                         std::size_t radix, std::size_t* encodings) {
+
+    for (std::size_t sdx = 0; sdx < count; ++sdx) {
+        std::size_t* digits = encodings + (sdx * slots);
+
+        hash_t hash = hashes[sdx];
+        for (std::size_t edx = 0; edx < slots; ++edx) {
+            digits[edx] = (std::size_t)(hash % radix);
+            hash /= radix;
+        }
+    }
+
+    return;
+}
+
+
+#ifdef TOWER_OF_HANOI_BATCH_AVX2
+
+static_assert(sizeof(std::size_t) == 8, "AVX2 kernels expect 64 bit digits.");
+
+//-- A 64 bit hash is split into base 5^13 chunks, so each chunk fits the
+//-- low 32 bits of a lane and x/5 becomes (x * 0xCCCCCCCD) >> 34.
+static const std::size_t        CHUNK_DIGITS = 13;
+static const unsigned long long CHUNK_BASE   = 1220703125ULL;
+
+
+//-- Split each lane into its value mod 5^13, returned, and its quotient,
+//-- written to rest. AVX2 has no 64 bit divide, so the quotient is guessed
+//-- in double precision, which is off by at most one either way, and the
+//-- remainder is then worked out exactly and fixed up.
+__attribute__((target("avx2")))
+static __m256i splitChunk(__m256i value, __m256i& rest) {
+
+    const __m256i low   = _mm256_set1_epi64x(0xFFFFFFFFULL);
+    const __m256i exp52 = _mm256_set1_epi64x(0x4330000000000000ULL);
+    const __m256d two52 = _mm256_set1_pd(4503599627370496.0);
+    const __m256d two32 = _mm256_set1_pd(4294967296.0);
+    const __m256i base  = _mm256_set1_epi64x((long long)CHUNK_BASE);
+    const __m256i one   = _mm256_set1_epi64x(1);
+
+    //-- Each 32 bit half goes to a double by setting it as the mantissa of 2^52.
+    __m256d high = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(_mm256_srli_epi64(value, 32), exp52)), two52);
+    __m256d lows = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(_mm256_and_si256(value, low), exp52)), two52);
+    __m256d guess = _mm256_floor_pd(_mm256_div_pd(_mm256_add_pd(_mm256_mul_pd(high, two32), lows),
+                                                  _mm256_set1_pd((double)CHUNK_BASE)));
+
+    //-- The guess is below 2^35, so back to an integer the same way.
+    __m256i quot = _mm256_sub_epi64(_mm256_castpd_si256(_mm256_add_pd(guess, two52)), exp52);
+
+    //-- remainder = value - quot * 5^13, with the product in two 32 bit halves.
+    __m256i prod = _mm256_add_epi64(_mm256_mul_epu32(quot, base),
+                                    _mm256_slli_epi64(_mm256_mul_epu32(_mm256_srli_epi64(quot, 32), base), 32));
+    __m256i rem  = _mm256_sub_epi64(value, prod);
+
+    //-- Fix a guess one too high, then one too low.
+    __m256i under = _mm256_cmpgt_epi64(_mm256_setzero_si256(), rem);
+    rem  = _mm256_add_epi64(rem, _mm256_and_si256(under, base));
+    quot = _mm256_sub_epi64(quot, _mm256_and_si256(under, one));
+
+    __m256i over = _mm256_cmpgt_epi64(rem, _mm256_sub_epi64(base, one));
+    rem  = _mm256_sub_epi64(rem, _mm256_and_si256(over, base));
+    quot = _mm256_add_epi64(quot, _mm256_and_si256(over, one));
+
+    rest = quot;
+    return rem;
+}
+
+
+__attribute__((target("avx2")))
+static void encodeAvx2(const std::size_t* encodings, std::size_t count, std::size_t slots,
+                       std::size_t radix, hash_t* hashes) {
+
+    //-- Offsets of the same slot in four neighbouring states.
+    const __m256i stride = _mm256_set_epi64x(3*slots, 2*slots, slots, 0);
+
+    std::size_t sdx = 0;
+    for (; sdx + 4 <= count; sdx += 4) {
+
+        const std::size_t* base = encodings + (sdx * slots);
+
+        //-- Horner's rule, with hash*2 or hash*5 done as shifts and adds.
+        __m256i hash = _mm256_setzero_si256();
+        for (std::size_t edx = slots; edx > 0; --edx) {
+            __m256i digit  = _mm256_i64gather_epi64((const long long*)(base + edx-1), stride, 8);
+            __m256i scaled = _mm256_slli_epi64(hash, (radix == 5) ? 2 : 1);
+            if (radix == 5) { scaled = _mm256_add_epi64(scaled, hash); }
+            hash = _mm256_add_epi64(scaled, digit);
+        }
+
+        _mm256_storeu_si256((__m256i*)(hashes + sdx), hash);
+    }
+
+    //-- Finish the last few states one by one.
+    encodeScalar(encodings + (sdx * slots), count - sdx, slots, radix, hashes + sdx);
+    return;
+}
+
+
+__attribute__((target("avx2")))
+static void decodeAvx2(const hash_t* hashes, std::size_t count, std::size_t slots,
+                       std::size_t radix, std::size_t* encodings) {
+
+    const __m256i one   = _mm256_set1_epi64x(1);
+    const __m256i magic = _mm256_set1_epi64x(0xCCCCCCCDULL);
+    alignas(32) unsigned long long lanes[4];
+
+    std::size_t sdx = 0;
+    for (; sdx + 4 <= count; sdx += 4) {
+
+        std::size_t* base = encodings + (sdx * slots);
+
+        //-- Mono digits are just the bits of the hash.
+        if (radix == 2) {
+            __m256i hash = _mm256_loadu_si256((const __m256i*)(hashes + sdx));
+            for (std::size_t edx = 0; edx < slots; ++edx) {
+                _mm256_store_si256((__m256i*)lanes, _mm256_and_si256(hash, one));
+                for (std::size_t ldx = 0; ldx < 4; ++ldx) { base[(ldx * slots) + edx] = lanes[ldx]; }
+                hash = _mm256_srli_epi64(hash, 1);
+            }
+            continue;
+        }
+
+        //-- Bicolor digits come out of each 32 bit chunk by repeated division by 5.
+        __m256i rest = _mm256_loadu_si256((const __m256i*)(hashes + sdx));
+        for (std::size_t cdx = 0; cdx < slots; cdx += CHUNK_DIGITS) {
+
+            __m256i chunk = splitChunk(rest, rest);
+            for (std::size_t edx = cdx; edx < slots && edx < cdx + CHUNK_DIGITS; ++edx) {
+                __m256i quot  = _mm256_srli_epi64(_mm256_mul_epu32(chunk, magic), 34);
+                __m256i digit = _mm256_sub_epi64(chunk, _mm256_add_epi64(_mm256_slli_epi64(quot, 2), quot));
+
+                _mm256_store_si256((__m256i*)lanes, digit);
+                for (std::size_t ldx = 0; ldx < 4; ++ldx) { base[(ldx * slots) + edx] = lanes[ldx]; }
+                chunk = quot;
+            }
+        }
+    }
+
+    //-- Finish the last few states one by one.
+    decodeScalar(hashes + sdx, count - sdx, slots, radix, encodings + (sdx * slots));
+    return;
+}
+
+#endif /* TOWER_OF_HANOI_BATCH_AVX2 */
+
+
+bool hashBatchIsVectorized() {
+#ifdef TOWER_OF_HANOI_BATCH_AVX2
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    return avx2;
+#else
+    return false;
+#endif
+}
+
+
+void encodeHashes(const std::size_t* encodings, std::size_t count, std::size_t slots,
+                  std::size_t radix, hash_t* hashes) {
+
+#ifdef TOWER_OF_HANOI_BATCH_AVX2
+    if (hashBatchIsVectorized() && (radix == 2 || radix == 5)) {
+        encodeAvx2(encodings, count, slots, radix, hashes);
+        return;
+    }
+#endif
+
+    encodeScalar(encodings, count, slots, radix, hashes);
+    return;
+}
+
+
+void decodeHashes(const hash_t* hashes, std::size_t count, std::size_t slots,
+                  std::size_t radix, std::size_t* encodings) {
+
+#ifdef TOWER_OF_HANOI_BATCH_AVX2
+    if (hashBatchIsVectorized() && (radix == 2 || radix == 5)) {
+        decodeAvx2(hashes, count, slots, radix, encodings);
+        return;
+    }
+#endif
+
+    decodeScalar(hashes, count, slots, radix, encodings);
+    return;
+}
@@ -0,0 +1,291 @@
+/* ================================================================================
+ * Copyright: (C) 2022, SIRRL Social and Intelligent Robotics Research Laboratory, 
+ *     University of Waterloo, All rights reserved.
+ * 
+ * Authors: 
+ *     Austin Kothig <austin.kothig@uwaterloo.ca>
+ * 
+ * CopyPolicy: Released under the terms of the MIT License. 
+ *     See the accompanying LICENSE file for details.
+ * ================================================================================
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <mappedTable.hpp>
+
+
+static const char TABLE_MAGIC[8] = { 'T','O','H','T','A','B','L','E' };
+
+//-- Bumped whenever the layout after the header changes.
+static const std::uint32_t TABLE_VERSION = 1;
+
+//-- Reads back differently on a machine of the other byte order.
+static const std::uint32_t TABLE_BYTE_ORDER = 0x01020304;
+
+static const std::uint32_t TABLE_UNREACHED = UINT32_MAX;
+static const std::uint8_t  TABLE_NO_MOVE   = UINT8_MAX;
+
+struct TableHeader {
+    char          magic[8];
+    std::uint32_t version;
+    std::uint32_t byte_order;
+    std::uint32_t pegs;
+    std::uint32_t disks;
+    std::uint32_t bicolor;
+    std::uint32_t ready;   // Set once every entry is written.
+    std::uint64_t count;
+};
+
+
+//-- Bytes of a table with the given number of ranks.
+static std::size_t getTableSize(hash_t count) {
+    return sizeof(TableHeader) + count * (sizeof(std::uint32_t) + sizeof(std::uint8_t));
+}
+
+
+//-- Lay out the table of a board in memory of getTableSize bytes, not yet
+//-- marked ready.
+static void fillTable(std::uint8_t* data, Board& board,
+                      const std::function<bool(const BoardSnapshot&, ull&)>& distance) {
+
+    TableHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, TABLE_MAGIC, sizeof(TABLE_MAGIC));
+    header.version    = TABLE_VERSION;
+    header.byte_order = TABLE_BYTE_ORDER;
+    header.pegs       = (std::uint32_t)board.getNumPegs();
+    header.disks      = (std::uint32_t)board.getNumDisks();
+    header.bicolor    = (std::uint32_t)board.getIsBicolor();
+    header.ready      = 0;
+    header.count      = board.getNumStates();
+    std::memcpy(data, &header, sizeof(header));
+
+    std::uint32_t* dists = (std::uint32_t*)(data + sizeof(TableHeader));
+    std::uint8_t*  moves = (std::uint8_t*)(dists + header.count);
+
+    //-- Distances of every rank.
+    BoardSnapshot state, next;
+    ull dist;
+    for (hash_t rank = 0; rank < header.count; ++rank) {
+        board.getSnapshotFromRank(rank, state);
+        dists[rank] = ( distance(state, dist) && dist < TABLE_UNREACHED ? (std::uint32_t)dist : TABLE_UNREACHED );
+    }
+
+    //-- Then the first legal move that gets closest to the goal, the same
+    //-- pick a solver makes from its own table.
+    for (hash_t rank = 0; rank < header.count; ++rank) {
+
+        board.getSnapshotFromRank(rank, state);
+
+        std::uint8_t best = TABLE_NO_MOVE;
+        ull best_dist = 0;
+        for (std::uint64_t legal = board.getLegalMoves(state); legal; legal &= legal - 1) {
+
+            int from, to;
+            std::size_t mdx = __builtin_ctzll(legal);
+            board.getMoveFromIndex(mdx, from, to);
+            board.applyMove(state, from, to, next);
+            if (!distance(next, dist)) { continue; }
+
+            if (best == TABLE_NO_MOVE || dist < best_dist) {
+                best      = (std::uint8_t)mdx;
+                best_dist = dist;
+            }
+        }
+        moves[rank] = best;
+    }
+}
+
+
+//-- Lay out a table in a file or shared memory object of the right size,
+//-- then mark it ready.
+static bool writeTable(int fd, Board& board,
+                       const std::function<bool(const BoardSnapshot&, ull&)>& distance) {
+
+    std::size_t size = getTableSize(board.getNumStates());
+    if (ftruncate(fd, (off_t)size) != 0) { return false; }
+
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) { return false; }
+
+    fillTable((std::uint8_t*)data, board, distance);
+    ((TableHeader*)data)->ready = 1;
+
+    bool synced = msync(data, size, MS_SYNC) == 0;
+    munmap(data, size);
+    return synced;
+}
+
+
+MappedTable::MappedTable() {
+    this->_data  = nullptr;
+    this->_size  = 0;
+    this->_dist  = nullptr;
+    this->_moves = nullptr;
+    this->_count = 0;
+}
+
+
+MappedTable::~MappedTable() {
+    this->close();
+}
+
+
+bool MappedTable::save(const std::string& path, Board& board,
+                       const std::function<bool(const BoardSnapshot&, ull&)>& distance) {
+
+    //-- Move indices have to fit a byte.
+    if (board.getNumPegs() > BoardSnapshot::MAX_PEGS) { return false; }
+
+    //-- A name of its own, so processes saving the same table at once each
+    //-- rename a whole file into place.
+    std::vector<char> temp(path.begin(), path.end());
+    temp.insert(temp.end(), { '.', 'X', 'X', 'X', 'X', 'X', 'X', '\0' });
+    int fd = mkstemp(temp.data());
+    if (fd < 0) { return false; }
+
+    bool written = fchmod(fd, 0644) == 0 && writeTable(fd, board, distance);
+    ::close(fd);
+    if (!written || std::rename(temp.data(), path.c_str()) != 0) {
+        std::remove(temp.data());
+        return false;
+    }
+
+    return true;
+}
+
+
+bool MappedTable::open(const std::string& path, Board& board) {
+
+    this->close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) { return false; }
+
+    bool mapped = this->attach(fd, board);
+    ::close(fd);
+    return mapped;
+}
+
+
+bool MappedTable::openShared(const std::string& name, Board& board, const std::function<bool()>& solve,
+                             const std::function<bool(const BoardSnapshot&, ull&)>& distance) {
+
+    this->close();
+    if (board.getNumPegs() > BoardSnapshot::MAX_PEGS) { return false; }
+
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) { return false; }
+
+    //-- One process builds the table while the rest wait on the lock, then
+    //-- find it ready. A builder that dies leaves it unready for the next.
+    if (flock(fd, LOCK_EX) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    bool mapped = this->attach(fd, board);
+    if (!mapped && solve()) {
+        mapped = writeTable(fd, board, distance) && this->attach(fd, board);
+    }
+
+    flock(fd, LOCK_UN);
+    ::close(fd);
+    return mapped;
+}
+
+
+bool MappedTable::attach(int fd, Board& board) {
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (std::size_t)info.st_size < sizeof(TableHeader)) { return false; }
+
+    //-- The mapping stays valid once the descriptor is closed.
+    std::size_t size = (std::size_t)info.st_size;
+    void* data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) { return false; }
+
+    //-- Only take finished tables of this version, made for the same board.
+    TableHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    hash_t count = board.getNumStates();
+    bool valid = std::memcmp(header.magic, TABLE_MAGIC, sizeof(TABLE_MAGIC)) == 0 &&
+        header.version == TABLE_VERSION && header.byte_order == TABLE_BYTE_ORDER &&
+        header.pegs == board.getNumPegs() && header.disks == board.getNumDisks() &&
+        header.bicolor == (std::uint32_t)board.getIsBicolor() && header.count == count &&
+        header.ready == 1 && size == getTableSize(count);
+    if (!valid) {
+        munmap(data, size);
+        return false;
+    }
+
+    this->_data  = (const std::uint8_t*)data;
+    this->_size  = size;
+    this->_dist  = (const std::uint32_t*)(this->_data + sizeof(TableHeader));
+    this->_moves = (const std::uint8_t*)(this->_dist + count);
+    this->_count = count;
+
+    return true;
+}
+
+
+void MappedTable::close() {
+
+    if (_data) { munmap((void*)_data, _size); }
+
+    this->_data  = nullptr;
+    this->_size  = 0;
+    this->_dist  = nullptr;
+    this->_moves = nullptr;
+    this->_count = 0;
+}
+
+
+bool MappedTable::isOpen() {
+    return _data != nullptr;
+}
+
+
+bool MappedTable::lookup(hash_t rank, ull& dist) {
+
+    if (!_data || rank >= _count || _dist[rank] == TABLE_UNREACHED) { return false; }
+
+    dist = _dist[rank];
+    return true;
+}
+
+
+bool MappedTable::getBestMove(hash_t rank, std::size_t& index) {
+
+    if (!_data || rank >= _count || _moves[rank] == TABLE_NO_MOVE) { return false; }
+
+    index = _moves[rank];
+    return true;
+}
+
+
+std::string MappedTable::getFileName(std::size_t pegs, std::size_t disks, bool isBicolor) {
+    return "table_" + std::to_string(pegs) + "p_" + std::to_string(disks) + "d_" +
+        ( isBicolor ? "bicolor" : "mono" ) + ".bin";
+}
+
+
+std::string MappedTable::getSharedName(std::size_t pegs, std::size_t disks, bool isBicolor) {
+    return "/toh_table_" + std::to_string(pegs) + "p_" + std::to_string(disks) + "d_" +
+        ( isBicolor ? "bicolor" : "mono" );
+}
+
+
+bool MappedTable::removeShared(const std::string& name) {
+    return shm_unlink(name.c_str()) == 0;
+}
@@ -0,0 +1,174 @@
+/* ================================================================================
+ * Copyright: (C) 2022, SIRRL Social and Intelligent Robotics Research Laboratory, 
+ *     University of Waterloo, All rights reserved.
+ * 
+ * Authors: 
+ *     Austin Kothig <austin.kothig@uwaterloo.ca>
+ * 
+ * CopyPolicy: Released under the terms of the MIT License. 
+ *     See the accompanying LICENSE file for details.
+ * ================================================================================
+ */
+
+#include <cstring>
+#include <fstream>
+
+#include <patternDatabase.hpp>
+
+
+//-- Files start with this tag, then the pegs, disks and bicolor flag as
+//-- 32 bit values and the number of distances as a 64 bit value.
+static const char PDB_MAGIC[8] = { 'T','O','H','P','D','B','0','1' };
+
+static const std::uint16_t PDB_UNREACHED = UINT16_MAX;
+
+
+//-- Pack the bits of value picked out by mask down into the lowest bits.
+static std::uint64_t gatherBits(std::uint64_t value, std::uint64_t mask) {
+
+    std::uint64_t out = 0;
+    for (std::uint64_t bit = 1; mask; mask &= mask - 1, bit <<= 1) {
+        if (value & mask & (~mask + 1)) { out |= bit; }
+    }
+
+    return out;
+}
+
+
+PatternDatabase::PatternDatabase(std::size_t pegs/*=3*/, std::size_t disks/*=3*/, bool isBicolor/*=false*/) {
+
+    this->_board = std::make_shared<Board>(pegs, disks, isBicolor);
+    this->_board->init();
+    this->_table.clear();
+}
+
+
+PatternDatabase::~PatternDatabase() {
+    this->_board.reset();
+    this->_table.clear();
+}
+
+
+bool PatternDatabase::build() {
+
+    BoardSnapshot goal;
+    if (!_board->setFromHashableState(_board->getHashableGoal()) || !_board->saveSnapshot(goal)) {
+        return false;
+    }
+
+    std::vector<std::uint16_t> table((std::size_t)_board->getNumStates(), PDB_UNREACHED);
+
+    //-- Moves can be undone, so the distance from the goal is the distance to it.
+    std::vector<hash_t> frontier(1, _board->getRankedState(goal));
+    std::vector<hash_t> reached;
+    table[(std::size_t)frontier[0]] = 0;
+
+    BoardSnapshot cur, next;
+    for (std::uint16_t dist = 1; !frontier.empty(); ++dist) {
+
+        if (dist == PDB_UNREACHED) { return false; }
+
+        reached.clear();
+        for (hash_t rank : frontier) {
+
+            _board->getSnapshotFromRank(rank, cur);
+            for (std::uint64_t legal = _board->getLegalMoves(cur); legal; legal &= legal - 1) {
+
+                int from, to;
+                _board->getMoveFromIndex(__builtin_ctzll(legal), from, to);
+                _board->applyMove(cur, from, to, next);
+
+                hash_t next_rank = _board->getRankedState(next);
+                if (table[(std::size_t)next_rank] != PDB_UNREACHED) { continue; }
+
+                table[(std::size_t)next_rank] = dist;
+                reached.push_back(next_rank);
+            }
+        }
+
+        frontier.swap(reached);
+    }
+
+    this->_table.swap(table);
+    return true;
+}
+
+
+bool PatternDatabase::save(const std::string& path) {
+
+    if (_table.empty()) { return false; }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) { return false; }
+
+    std::uint32_t settings[3] = { (std::uint32_t)_board->getNumPegs(),
+                                  (std::uint32_t)_board->getNumDisks(),
+                                  (std::uint32_t)_board->getIsBicolor() };
+    std::uint64_t count = _table.size();
+
+    file.write(PDB_MAGIC, sizeof(PDB_MAGIC));
+    file.write((const char*)settings, sizeof(settings));
+    file.write((const char*)&count, sizeof(count));
+    file.write((const char*)_table.data(), count * sizeof(std::uint16_t));
+
+    return (bool)file;
+}
+
+
+bool PatternDatabase::load(const std::string& path) {
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file) { return false; }
+
+    char          magic[sizeof(PDB_MAGIC)];
+    std::uint32_t settings[3];
+    std::uint64_t count;
+    file.read(magic, sizeof(magic));
+    file.read((char*)settings, sizeof(settings));
+    file.read((char*)&count, sizeof(count));
+
+    //-- Only take tables made for the same pattern.
+    if (!file || std::memcmp(magic, PDB_MAGIC, sizeof(PDB_MAGIC)) != 0) { return false; }
+    if (settings[0] != _board->getNumPegs()    || settings[1] != _board->getNumDisks() ||
+        settings[2] != (std::uint32_t)_board->getIsBicolor() || count != _board->getNumStates()) {
+        return false;
+    }
+
+    std::vector<std::uint16_t> table((std::size_t)count);
+    file.read((char*)table.data(), count * sizeof(std::uint16_t));
+    if (!file) { return false; }
+
+    this->_table.swap(table);
+    return true;
+}
+
+
+bool PatternDatabase::isBuilt() {
+    return !_table.empty();
+}
+
+
+std::size_t PatternDatabase::getNumDisks() {
+    return _board->getNumDisks();
+}
+
+
+ull PatternDatabase::lookup(const BoardSnapshot& state, std::uint64_t disks) {
+
+    //-- Drop the other disks from every plane, which keeps the relative order
+    //-- of the pattern's sizes, and rank what is left on the pattern board.
+    BoardSnapshot pattern;
+    for (std::size_t pdx = 0; pdx < _board->getNumPegs(); ++pdx) {
+        pattern.blacks[pdx] = gatherBits(state.blacks[pdx], disks);
+        pattern.whites[pdx] = gatherBits(state.whites[pdx], disks);
+        pattern.order[pdx]  = gatherBits(state.order[pdx],  disks);
+    }
+
+    return _table[(std::size_t)_board->getRankedState(pattern)];
+}
+
+
+std::string PatternDatabase::getFileName(std::size_t pegs, std::size_t disks, bool isBicolor) {
+    return "pdb_" + std::to_string(pegs) + "p_" + std::to_string(disks) + "d_" +
+        ( isBicolor ? "bicolor" : "mono" ) + ".bin";
+}
@@ -88,7 +88,7 @@ action Player::getAction() {
             std::string hash;
             hash = input[1];
 
-            //-- Check that this is an integer (unsigned long long).
+            //-- Check that this is an unsigned integer.
             if (!this->isStringInt(hash, false)) {
                 ret.selection = action::HELP;
                 ret.msg = "[Error] Received ``" + hash + "``. Expected an unsigned integer.\n\n"
@@ -98,14 +98,12 @@ action Player::getAction() {
 
             //-- Set meets selection criteria. Return it.
             ret.selection = action::SET;
-            try {
-                ret.hash = std::stoull(hash);
-            } catch(std::out_of_range) {
+            if (!stringToHash(hash, ret.hash)) {
 
                 ret.selection = action::HELP;
-                ret.msg = "[Error] Received an unsigned long long value out of range. Got ``" 
-                + hash + "``. Please ensure hash is a propper unsigned long long.\n\n" 
-                + this->getHelpString();
+                ret.msg = "[Error] Received a hash value out of range. Got ``" 
+                + hash + "``. Please ensure hash fits in " + std::to_string(sizeof(hash_t) * 8) 
+                + " bits.\n\n" + this->getHelpString();
 
             }
 
@@ -184,7 +182,7 @@ std::string Player::getHelpString() {
     "    hint                ``request a hint for what next action`` \n"
     "    hash                ``get the current board state hash``    \n"
     "    dist                ``get the distance to the goal state``  \n"
-    "    set longlong(hash)  ``set the current board state as hash`` \n"
+    "    set uint(hash)      ``set the current board state as hash`` \n"
     "    quit/exit           ``stop the game and exit``              \n"
     "";
 
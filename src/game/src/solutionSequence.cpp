@@ -0,0 +1,98 @@
+/* ================================================================================
+ * Copyright: (C) 2022, SIRRL Social and Intelligent Robotics Research Laboratory, 
+ *     University of Waterloo, All rights reserved.
+ * 
+ * Authors: 
+ *     Austin Kothig <austin.kothig@uwaterloo.ca>
+ * 
+ * CopyPolicy: Released under the terms of the MIT License. 
+ *     See the accompanying LICENSE file for details.
+ * ================================================================================
+ */
+
+#include <algorithm>
+
+#include <solutionSequence.hpp>
+
+
+SolutionSequence::SolutionSequence(std::size_t disks/*=3*/) {
+    this->_num_disk = disks;
+}
+
+
+bool SolutionSequence::isValid() const {
+    return _num_disk <= MAX_DISKS;
+}
+
+
+ull SolutionSequence::getLength() const {
+
+    //-- Larger sequences have more moves than a ull counts, so have none.
+    if (!this->isValid()) { return 0; }
+    return ( _num_disk == 64 ? ~0ULL : (1ULL << _num_disk) - 1 );
+}
+
+
+pii SolutionSequence::getMove(ull index) const {
+
+    if (index >= getLength()) { return std::make_pair(-1,-1); }
+
+    //-- The k-th move goes from (k & k-1) mod 3 to ((k | k-1) + 1) mod 3, which
+    //-- ends on peg 2 for an odd number of disks, and on peg 1 for even. The
+    //-- + 1 comes after the mod, as k | k-1 is all ones for k = 2^63.
+    ull k    = index + 1;
+    int from = (int)((k & (k - 1)) % 3);
+    int to   = (int)((((k | (k - 1)) % 3) + 1) % 3);
+    if (_num_disk % 2 == 0) {
+        from = ( from == 0 ? 0 : 3 - from );
+        to   = ( to   == 0 ? 0 : 3 - to   );
+    }
+
+    return std::make_pair(from, to);
+}
+
+
+int SolutionSequence::getPeg(ull moves, std::size_t size) const {
+
+    if (!this->isValid() || size == 0 || size > _num_disk || moves > getLength()) { return -1; }
+
+    //-- The disk of a size first moves halfway through its period of 2^size
+    //-- moves, then once every period after that. A period of 2^64 moves
+    //-- never ends within a sequence, and a ull can't shift that far.
+    ull half  = 1ULL << (size - 1);
+    ull times = ( size < 64 ? moves >> size : 0 ) + ( (moves & ((half << 1) - 1)) >= half ? 1 : 0 );
+
+    //-- Disks with the parity of the largest step towards peg 2 first, the
+    //-- others towards peg 1.
+    std::size_t step = ( (_num_disk - size) % 2 == 0 ? 2 : 1 );
+    return (int)(((times % 3) * step) % 3);
+}
+
+
+bool SolutionSequence::getRankAfter(ull moves, hash_t& rank) const {
+
+    if (!this->isValid() || moves > getLength()) { return false; }
+
+    //-- Each disk is one base 3 digit, the largest disk lowest.
+    hash_t place = 1;
+    hash_t value = 0;
+    const hash_t limit = ~((hash_t)0);
+    for (std::size_t size = _num_disk; size > 0; --size) {
+        value += place * (hash_t)this->getPeg(moves, size);
+        if (size > 1 && place > limit / 3) { return false; }
+        place *= 3;
+    }
+
+    rank = value;
+    return true;
+}
+
+
+SolutionSequence::iterator SolutionSequence::begin(ull index/*=0*/) const {
+    return iterator(this, std::min(index, getLength()));
+}
+
+
+SolutionSequence::iterator SolutionSequence::end() const {
+    return iterator(this, getLength());
+}
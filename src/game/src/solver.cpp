@@ -10,10 +10,20 @@
  * ================================================================================
  */
 
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <tuple>
+
 #include <solver.hpp>
 
 
-Solver::Solver(std::size_t pegs/*=3*/, std::size_t disks/*=3*/, bool isBicolor/*=false*/) {
+Solver::Solver(std::size_t pegs/*=3*/, std::size_t disks/*=3*/, bool isBicolor/*=false*/, 
+               const solverOptions& options/*=solverOptions()*/) {
 
     //-- Create a fresh board and initialize it.
     this->_board = std::make_shared<Board>(pegs, disks, isBicolor);
@@ -26,8 +36,45 @@ Solver::Solver(std::size_t pegs/*=3*/, std::size_t disks/*=3*/, bool isBicolor/*
     this->_sssp.clear();
     this->_dist.clear();
     this->_moves.clear();
+    this->_table.clear();
     this->_solved = false;
 
+    //-- Closed form answers only exist for 3 pegs, and every other mode needs
+    //-- the board to fit a snapshot. Anything else is solved up front.
+    bool fits = pegs <= BoardSnapshot::MAX_PEGS;
+    this->_search = options.search;
+    if (!fits || (_search == solverOptions::ANALYTIC && pegs != 3)) { this->_search = solverOptions::BFS; }
+
+    //-- Only a BFS solve stores states, and FLAT and DISK have no room for 
+    //-- symmetry.
+    this->_storage = MAP;
+    if (fits && _search == solverOptions::BFS) {
+        switch (options.storage) {
+        case solverOptions::FLAT: this->_storage = FLAT; break;
+        case solverOptions::DISK: this->_storage = DISK; break;
+        default:                  this->_storage = ( options.symmetry ? CANONICAL : MAP ); break;
+        }
+    }
+
+    this->_max_nodes = options.max_nodes;
+    this->_local_depth  = options.local_depth;
+    this->_local_states = options.local_states;
+    this->_pdb_disks = options.pdb_disks;
+    this->_pdb_path  = options.pdb_path;
+
+    //-- Precomputed tables are only kept for full breadth-first solves.
+    bool full = fits && _search == solverOptions::BFS;
+    this->_table_path = ( full ? options.table_path : "" );
+    this->_shared     = full && options.shared;
+
+    //-- Disk storage only sets up its table here, the files come with solve.
+    if (this->_storage == DISK) { this->_disk_table = std::make_shared<DiskTable>(options.disk_path, options.disk_buffer); }
+
+    //-- Zero threads means one per core.
+    this->_threads = options.threads;
+    if (this->_threads == 0) { this->_threads = std::thread::hardware_concurrency(); }
+    if (this->_threads == 0) { this->_threads = 1; }
+
     //-- Get all combinations of possible game moves.
     for (int i = 0; i < pegs; ++i) {
         for (int j = 0; j < pegs; ++j) {
@@ -50,6 +97,12 @@ Solver::~Solver() {
     this->_sssp.clear();
     this->_dist.clear();
     this->_moves.clear();
+    this->_table.clear();
+    this->_next.clear();
+    this->_explored.clear();
+    this->_patterns.clear();
+    this->_disk_table.reset();
+    this->_mapped_table.reset();
 
     // <REMOVE>
     std::cout << "[debug] Solver Destroyed." << std::endl;
@@ -62,9 +115,220 @@ void Solver::solve() {
     //-- TODO: If it's already solved reset/return?
     if (_solved) { return; }
 
+    //-- Closed form answers need nothing up front.
+    if (_search == solverOptions::ANALYTIC) {
+        _solved = true;
+        return;
+    }
+
+    //-- Single query searches only warm up the path from the start.
+    if (_search != solverOptions::BFS) {
+        this->searchQuery(_start_hash);
+        _solved = true;
+        return;
+    }
+
+    //-- A table saved by an earlier solve needs no search at all.
+    if (this->mapTable()) {
+        _solved = true;
+        return;
+    }
+
+    //-- Nor does one another process of the host has already shared. If 
+    //-- sharing fails the solve falls back to our own storage.
+    if (this->shareTable()) {
+        _solved = true;
+        return;
+    }
+
+    if (!_solved) { this->searchStorage(); }
+    this->saveTable();
+    return;
+}
+
+
+void Solver::searchStorage() {
+
+    switch (_storage) {
+    case FLAT:      this->searchFlat(*_board);      break;
+    case DISK:      this->searchDisk(*_board);      break;
+    case CANONICAL: this->searchCanonical(*_board); break;
+    default:        this->searchTable();            break;
+    }
+
+    return;
+}
+
+
+bool Solver::mapTable() {
+
+    if (_table_path.empty()) { return false; }
+
+    std::string file = _table_path + "/" + 
+        MappedTable::getFileName(_board->getNumPegs(), _board->getNumDisks(), _board->getIsBicolor());
+
+    auto table = std::make_shared<MappedTable>();
+    if (!table->open(file, *_board)) { return false; }
+
+    this->useTable(table);
+    return true;
+}
+
+
+bool Solver::shareTable() {
+
+    if (!_shared) { return false; }
+
+    std::string name = MappedTable::getSharedName(_board->getNumPegs(), _board->getNumDisks(), _board->getIsBicolor());
+
+    //-- The search moves the board around, so fill the table with one of our own.
+    Board board(_board->getNumPegs(), _board->getNumDisks(), _board->getIsBicolor());
+    board.init();
+
+    auto table = std::make_shared<MappedTable>();
+    bool shared = table->openShared(name, board, 
+        [this]() { 
+            this->searchStorage(); 
+            return _solved; 
+        },
+        [this](const BoardSnapshot& state, ull& dist) {
+            return this->findDistance(state, dist);
+        });
+
+    if (!shared) {
+        std::cerr << "[warning] Could not share the solution table as " << name << std::endl;
+        return false;
+    }
+
+    this->useTable(table);
+    return true;
+}
+
+
+void Solver::useTable(std::shared_ptr<MappedTable> table) {
+
+    this->_mapped_table = table;
+
+    //-- Queries go to the table from now on, so free our own storage.
+    this->_storage = MAPPED;
+    std::unordered_map<hash_t,mvec,HashHasher>().swap(this->_sssp);
+    std::unordered_map<hash_t,ull,HashHasher>().swap(this->_dist);
+    std::vector<std::uint32_t>().swap(this->_table);
+    this->_disk_table.reset();
+}
+
+
+void Solver::saveTable() {
+
+    if (_table_path.empty() || !_solved) { return; }
+
+    std::string file = _table_path + "/" + 
+        MappedTable::getFileName(_board->getNumPegs(), _board->getNumDisks(), _board->getIsBicolor());
+
+    //-- The search moves the board around, so save with one of our own.
+    Board board(_board->getNumPegs(), _board->getNumDisks(), _board->getIsBicolor());
+    board.init();
+    bool saved = MappedTable::save(file, board, [this](const BoardSnapshot& state, ull& dist) {
+        return this->findDistance(state, dist);
+    });
+
+    if (!saved) {
+        std::cerr << "[warning] Could not save the solution table to " << file << std::endl;
+    }
+}
+
+
+void Solver::searchTable() {
+
+    //-- Prefer a compile time board for these settings, else use our own.
+    bool fixed = dispatchFixedBoard(_board->getNumPegs(), _board->getNumDisks(), _board->getIsBicolor(),
+        [this](auto& board) { this->search(board); });
+
+    //-- Boards too wide for a snapshot are searched through their hashes.
+    if (!fixed && _board->getNumPegs() <= BoardSnapshot::MAX_PEGS) {
+        this->search(*_board);
+    } else if (!fixed) {
+        this->searchByHash(*_board);
+    }
+
+    return;
+}
+
+
+template<typename BoardType>
+void Solver::search(BoardType& board) {
+
+    typedef typename BoardType::Snapshot Snapshot;
+
+    //-- Start the board at the goal state and keep a snapshot of it.
+    hash_t goal_hash = board.getHashableGoal();
+    Snapshot goal;
+    if (!board.setFromHashableState(goal_hash) || !board.saveSnapshot(goal)) {
+        std::cerr << "[error] Could not set goal hash!" << std::endl;
+        return;
+    }
+
+    //-- Init a queue for the breadth-first search in getting the 
+    //-- single-source shortest path to all existing states. Snapshots
+    //-- are queued so nodes expand without decoding their hash.
+    std::queue<Snapshot> bfs; 
+
+    //-- Seed the bfs with our first state that we're looking at.
+    bfs.push(goal);
+    _dist[goal_hash] = 0;
+
+    //-- Loop until all states have been reached.
+    Snapshot next;
+    while (!bfs.empty()) {
+
+        //-- Get the current state.
+        const Snapshot& cur = bfs.front();
+        hash_t cur_state = cur.getHashableState();
+
+        //-- Iterate through only the legal moves, whose bits are in the
+        //-- same order as the possible moves.
+        mvec state_moves;
+        for (std::uint64_t legal = board.getLegalMoves(cur); legal; legal &= legal - 1) {
+
+            //-- Make the move on a copy.
+            std::size_t mdx = __builtin_ctzll(legal);
+            board.applyMove(cur, _moves[mdx].first, _moves[mdx].second, next);
+
+            //-- If this state has not been seen before, set how many
+            //-- moves there are to the goal state and queue it up.
+            hash_t move_hash = next.getHashableState();
+            if (_dist.find(move_hash) == _dist.end()) {
+                _dist[move_hash] = _dist[cur_state] + 1;
+                bfs.push(next);
+            }
+
+            //-- Add this move as an edge to the sssp possible states.
+            move current_move;
+            current_move.from = _moves[mdx].first;
+            current_move.to   = _moves[mdx].second;
+            current_move.hash =  move_hash;
+            current_move.dist = _dist[move_hash];
+
+            state_moves.push_back(current_move);
+        }
+
+        //-- Set the computed sssp moves for the current state.
+        _sssp[cur_state] = state_moves;
+        bfs.pop();
+    }
+
+    //-- This has been computed!
+    _solved = true;
+
+    return;
+}
+
+
+void Solver::searchByHash(Board& board) {
+
     //-- Get the hash for the goal state, then set the board as it.
-    ull goal_hash = _board->getHashableGoal();
-    //bool success  = _board->setFromHashableState(goal_hash); //TODO: Needed?
+    hash_t goal_hash = board.getHashableGoal();
+    //bool success  = board.setFromHashableState(goal_hash); //TODO: Needed?
 
     //if (!success) {
     //    std::cerr << "[error] Could not set goal hash!" << std::endl;
@@ -73,7 +337,7 @@ void Solver::solve() {
 
     //-- Init a queue for the breadth-first search in getting the 
     //-- single-source shortest path to all existing states.
-    std::queue<ull> bfs; 
+    std::queue<hash_t> bfs; 
 
     //-- Seed the bfs with our first state that we're looking at.
     bfs.push(goal_hash);
@@ -83,7 +347,7 @@ void Solver::solve() {
     while (!bfs.empty()) {
 
         //-- Get the current state.
-        ull cur_state = bfs.front();
+        hash_t cur_state = bfs.front();
         bfs.pop();
 
         //-- Check and see if this state has alread been seen.
@@ -92,7 +356,7 @@ void Solver::solve() {
         }
 
         //-- Set the board state to the current state.
-        bool success = _board->setFromHashableState(cur_state);
+        bool success = board.setFromHashableState(cur_state);
         if (!success) {
             std::cerr << "[error] Could not set current hash!" << std::endl;
             return;
@@ -103,15 +367,15 @@ void Solver::solve() {
         for (std::size_t mdx = 0; mdx < _moves.size(); ++mdx) {
 
             //-- Try the move, if it didn't take, move onto the next.
-            success = _board->move(_moves[mdx].first, _moves[mdx].second);
+            success = board.move(_moves[mdx].first, _moves[mdx].second);
             if (!success) { continue; }
 
             //-- Get the hash of the successful move.    
-            ull move_hash = _board->getHashableState();
+            hash_t move_hash = board.getHashableState();
             bfs.push(move_hash);
 
             //-- Reverse the move.
-            success = _board->move(_moves[mdx].second, _moves[mdx].first);
+            success = board.move(_moves[mdx].second, _moves[mdx].first);
 
             //-- Error check the state.
             if (!success) {
@@ -143,31 +407,769 @@ void Solver::solve() {
     //-- This has been computed!
     _solved = true;
 
-    std::cout << "Num states=" << _sssp.size() << std::endl;
-    
     return;
 }
 
 
-pii Solver::getBestMove(ull hash) {
+void Solver::searchCanonical(Board& board) {
 
-    if (_sssp.find(hash) == _sssp.end()) { return std::make_pair(-1,-1); }
-    mvec state_moves = _sssp[hash];
+    //-- Start the board at the goal state and keep a snapshot of it.
+    hash_t goal_hash = board.getHashableGoal();
+    BoardSnapshot goal;
+    if (!board.setFromHashableState(goal_hash) || !board.saveSnapshot(goal)) {
+        std::cerr << "[error] Could not set goal hash!" << std::endl;
+        return;
+    }
 
-    // <REMOVE>
-    std::cout << "Hash: " << hash << std::endl;
-    std::size_t min_idx = 0;
-    std::cout << "\t - (" << state_moves[min_idx].from << "," << state_moves[min_idx].to << ")  -->  " 
-                  << state_moves[min_idx].dist << ":" << state_moves[min_idx].hash << std::endl;
-    // <\REMOVE>
+    //-- Any member of a class of symmetric states can be expanded, so the
+    //-- queue holds whichever snapshot first reached each canonical state.
+    std::vector<std::size_t> pegs, next_pegs, canonical_peg(board.getNumPegs());
+    std::queue<BoardSnapshot> bfs;
+
+    bfs.push(goal);
+    _dist[board.getCanonicalState(goal, pegs)] = 0;
+
+    BoardSnapshot next;
+    while (!bfs.empty()) {
+
+        //-- Get the current state and how its pegs map to the canonical ones.
+        const BoardSnapshot& cur = bfs.front();
+        hash_t cur_state = board.getCanonicalState(cur, pegs);
+        for (std::size_t pdx = 0; pdx < pegs.size(); ++pdx) {
+            canonical_peg[pegs[pdx]] = pdx;
+        }
+
+        //-- Iterate through only the legal moves.
+        mvec state_moves;
+        for (std::uint64_t legal = board.getLegalMoves(cur); legal; legal &= legal - 1) {
+
+            std::size_t mdx = __builtin_ctzll(legal);
+            board.applyMove(cur, _moves[mdx].first, _moves[mdx].second, next);
+
+            hash_t move_hash = board.getCanonicalState(next, next_pegs);
+            if (_dist.find(move_hash) == _dist.end()) {
+                _dist[move_hash] = _dist[cur_state] + 1;
+                bfs.push(next);
+            }
+
+            //-- Add this move as an edge, with pegs of the canonical state.
+            move current_move;
+            current_move.from = canonical_peg[_moves[mdx].first];
+            current_move.to   = canonical_peg[_moves[mdx].second];
+            current_move.hash =  move_hash;
+            current_move.dist = _dist[move_hash];
+
+            state_moves.push_back(current_move);
+        }
+
+        _sssp[cur_state] = state_moves;
+        bfs.pop();
+    }
+
+    //-- This has been computed!
+    _solved = true;
+
+    return;
+}
+
+
+void Solver::searchFlat(Board& board) {
+
+    //-- Every rank starts out unreached.
+    const std::uint32_t unreached = UINT32_MAX;
+    _table.assign(board.getNumStates(), unreached);
+
+    hash_t goal_hash = board.getHashableGoal();
+    if (!board.setFromHashableState(goal_hash)) {
+        std::cerr << "[error] Could not set goal hash!" << std::endl;
+        return;
+    }
+
+    //-- Ranks are all a level needs, states are rebuilt from them.
+    std::vector<hash_t> frontier(1, board.getRankedState());
+    std::vector<hash_t> upcoming;
+    _table[frontier[0]] = 0;
+
+    //-- Each worker keeps the ranks it claims for the next level in its own
+    //-- list, and copies them into its slice of the next frontier.
+    const std::size_t                chunk   = 256;
+    const std::size_t                workers = _threads;
+    std::vector<std::vector<hash_t>> found(workers);
+    std::vector<std::size_t>         offsets(workers + 1, 0);
+    std::atomic<std::size_t>         claimed(0);
+    std::uint32_t                    depth   = 0;
+    std::size_t                      reached = 1;
+    bool                             done    = false;
+
+    //-- Workers wait for each other between the steps of a level. The last
+    //-- to arrive runs the step's bookkeeping before letting the rest go.
+    std::mutex              mutex;
+    std::condition_variable arrived;
+    std::size_t             waiting = 0, generation = 0;
+    auto barrier = [&](const std::function<void()>& last) {
+        std::unique_lock<std::mutex> lock(mutex);
+        std::size_t current = generation;
+        if (++waiting == workers) {
+            last();
+            waiting = 0;
+            generation += 1;
+            arrived.notify_all();
+        } else {
+            arrived.wait(lock, [&]() { return generation != current; });
+        }
+    };
+
+    auto worker = [&](std::size_t tdx) {
+
+        BoardSnapshot cur, next;
+        while (!done) {
+
+            //-- Expand chunks of the frontier until it is used up. A rank is
+            //-- claimed by swapping its distance in over unreached, so only
+            //-- one worker ever finds it.
+            found[tdx].clear();
+            for (std::size_t start = claimed.fetch_add(chunk); start < frontier.size(); start = claimed.fetch_add(chunk)) {
+                std::size_t end = std::min(start + chunk, frontier.size());
+                for (std::size_t fdx = start; fdx < end; ++fdx) {
+
+                    board.getSnapshotFromRank(frontier[fdx], cur);
+                    for (std::uint64_t legal = board.getLegalMoves(cur); legal; legal &= legal - 1) {
+
+                        std::size_t mdx = __builtin_ctzll(legal);
+                        board.applyMove(cur, _moves[mdx].first, _moves[mdx].second, next);
+
+                        hash_t        move_rank = board.getRankedState(next);
+                        std::uint32_t expected  = unreached;
+                        if (__atomic_load_n(&_table[move_rank], __ATOMIC_RELAXED) == unreached &&
+                            __atomic_compare_exchange_n(&_table[move_rank], &expected, depth + 1, 
+                                                        false, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                            found[tdx].push_back(move_rank);
+                        }
+                    }
+                }
+            }
+
+            //-- Lay out the next frontier once every list is known.
+            barrier([&]() {
+                for (std::size_t wdx = 0; wdx < workers; ++wdx) {
+                    offsets[wdx+1] = offsets[wdx] + found[wdx].size();
+                }
+                upcoming.resize(offsets[workers]);
+            });
+
+            std::copy(found[tdx].begin(), found[tdx].end(), upcoming.begin() + offsets[tdx]);
+
+            //-- Move on to the next level.
+            barrier([&]() {
+                frontier.swap(upcoming);
+                claimed  = 0;
+                depth   += 1;
+                reached += frontier.size();
+                done     = frontier.empty();
+            });
+        }
+    };
+
+    //-- The calling thread is one of the workers.
+    std::vector<std::thread> pool;
+    for (std::size_t tdx = 1; tdx < workers; ++tdx) {
+        pool.emplace_back(worker, tdx);
+    }
+    worker(0);
+    for (std::size_t tdx = 0; tdx < pool.size(); ++tdx) {
+        pool[tdx].join();
+    }
+
+    //-- This has been computed!
+    _solved = true;
+
+    return;
+}
+
+
+void Solver::searchDisk(Board& board) {
+
+    if (!_disk_table->build(board)) {
+        std::cerr << "[error] Could not write the disk table!" << std::endl;
+        return;
+    }
+
+    _solved = true;
+
+    return;
+}
+
+
+bool Solver::searchAStar(hash_t start) {
+
+    //-- Already on a cached path.
+    if (_dist.find(start) != _dist.end()) { return true; }
+
+    BoardSnapshot state;
+    if (!_board->setFromHashableState(start) || !_board->saveSnapshot(state)) { return false; }
+
+    //-- Every generated state, with how it was first reached at its cost.
+    struct node {
+        BoardSnapshot state;
+        std::size_t   parent;
+        pii           move;
+        ull           cost;  // Moves from the start.
+        ull           rest;  // Moves to the goal, exact if known else a lower bound.
+        bool          exact;
+    };
+
+    //-- Open states by least estimated total, then least estimated rest.
+    typedef std::tuple<ull,ull,std::size_t> entry;
+    std::priority_queue<entry, std::vector<entry>, std::greater<entry>> open;
+    std::unordered_map<hash_t,ull,HashHasher> best;
+    std::vector<node> nodes;
+
+    auto visit = [&](const BoardSnapshot& next, std::size_t parent, pii move, ull cost) {
+
+        //-- Only keep a state if it was reached cheaper than before.
+        auto seen = best.find(next.getHashableState());
+        if (seen != best.end() && seen->second <= cost) { return; }
+        best[next.getHashableState()] = cost;
+
+        //-- Cached states and the goal are known exactly.
+        auto cached = _dist.find(next.getHashableState());
+        node n = { next, parent, move, cost, 0, true };
+        if (cached != _dist.end()) { n.rest = cached->second; }
+        else if (!next.isGoal())   { n.rest = _board->getLowerBound(next); n.exact = false; }
+
+        nodes.push_back(n);
+        open.push(std::make_tuple(cost + n.rest, n.rest, nodes.size() - 1));
+    };
+
+    visit(state, 0, std::make_pair(-1,-1), 0);
+
+    //-- With an admissible bound, the first exact state off the queue ends
+    //-- a shortest path, since nothing left open can beat its total.
+    std::size_t   end = 0;
+    bool          found = false;
+    BoardSnapshot next;
+    while (!open.empty()) {
+
+        std::size_t idx = std::get<2>(open.top());
+        open.pop();
+
+        //-- Skip states that have since been reached cheaper.
+        if (nodes[idx].cost > best[nodes[idx].state.getHashableState()]) { continue; }
+        if (nodes[idx].exact) { end = idx; found = true; break; }
+        if (_max_nodes && nodes.size() > _max_nodes) { break; }
+
+        BoardSnapshot cur = nodes[idx].state;
+        ull           cost = nodes[idx].cost;
+        for (std::uint64_t legal = _board->getLegalMoves(cur); legal; legal &= legal - 1) {
+            std::size_t mdx = __builtin_ctzll(legal);
+            _board->applyMove(cur, _moves[mdx].first, _moves[mdx].second, next);
+            visit(next, idx, _moves[mdx], cost + 1);
+        }
+    }
+
+    if (!found) { return false; }
+
+    //-- Cache the exact distance and next move of every state on the path.
+    ull total = nodes[end].cost + nodes[end].rest;
+    _dist[nodes[end].state.getHashableState()] = nodes[end].rest;
+    for (std::size_t idx = end; idx != 0; idx = nodes[idx].parent) {
+        const node& parent = nodes[nodes[idx].parent];
+        _dist[parent.state.getHashableState()] = total - parent.cost;
+        _next[parent.state.getHashableState()] = nodes[idx].move;
+    }
+
+    return true;
+}
+
+
+bool Solver::searchIDAStar(hash_t start) {
+
+    //-- Already on a cached path.
+    if (_dist.find(start) != _dist.end()) { return true; }
+    if (_patterns.empty() && !this->loadPatterns()) { return false; }
+
+    BoardSnapshot state;
+    if (!_board->setFromHashableState(start) || !_board->saveSnapshot(state)) { return false; }
+
+    //-- Raise the bound to the least estimate that went over it, until a 
+    //-- pass gets through. The bound never passes the shortest distance.
+    std::vector<BoardSnapshot> path(1, state);
+    std::vector<pii>           moves;
+    std::size_t                nodes = 0;
+    bool                       found = false;
+    ull                        rest  = 0;
+    for (ull bound = this->estimate(state); !found; ) {
+        _transpositions.clear();
+        bound = this->deepen(path, moves, bound, nodes, found, rest);
+        if (!found && bound == ULLONG_MAX) { _transpositions.clear(); return false; }
+    }
+    _transpositions.clear();
+
+    //-- Cache the exact distance and next move of every state on the path.
+    ull total = (path.size() - 1) + rest;
+    for (std::size_t sdx = 0; sdx < path.size(); ++sdx) {
+        _dist[path[sdx].getHashableState()] = total - sdx;
+        if (sdx < moves.size()) { _next[path[sdx].getHashableState()] = moves[sdx]; }
+    }
+
+    return true;
+}
+
+
+ull Solver::deepen(std::vector<BoardSnapshot>& path, std::vector<pii>& moves, ull bound, 
+                   std::size_t& nodes, bool& found, ull& rest) {
+
+    BoardSnapshot cur  = path.back();
+    ull           cost = path.size() - 1;
+
+    //-- The goal and cached states are known exactly, so they end the pass
+    //-- if the path through them fits the bound.
+    auto cached = _dist.find(cur.getHashableState());
+    if (cur.isGoal() || cached != _dist.end()) {
+        ull exact = ( cur.isGoal() ? 0 : cached->second );
+        if (cost + exact <= bound) { found = true; rest = exact; }
+        return cost + exact;
+    }
+
+    ull total = cost + this->estimate(cur);
+    if (total > bound) { return total; }
+
+    //-- Many move orders reach the same state, so skip states already
+    //-- expanded as cheaply in this pass, while there is room to remember them.
+    auto seen = _transpositions.find(cur.getHashableState());
+    if (seen != _transpositions.end() && seen->second <= cost) { return ULLONG_MAX; }
+    if (seen != _transpositions.end()) { seen->second = cost; }
+    else if (_transpositions.size() < TRANSPOSITION_LIMIT) { _transpositions[cur.getHashableState()] = cost; }
+
+    if (_max_nodes && ++nodes > _max_nodes) { return ULLONG_MAX; }
+
+    //-- The peg the last move went to has the disk that was just moved on top.
+    int last = ( moves.empty() ? -1 : moves.back().second );
+
+    ull least = ULLONG_MAX;
+    BoardSnapshot next;
+    for (std::uint64_t legal = _board->getLegalMoves(cur); legal; legal &= legal - 1) {
+
+        std::size_t mdx = __builtin_ctzll(legal);
+        if (_moves[mdx].first == last) { continue; }
+
+        _board->applyMove(cur, _moves[mdx].first, _moves[mdx].second, next);
+        path.push_back(next);
+        moves.push_back(_moves[mdx]);
+
+        ull next_total = this->deepen(path, moves, bound, nodes, found, rest);
+        if (found) { return next_total; }
+
+        path.pop_back();
+        moves.pop_back();
+        least = std::min(least, next_total);
+
+        //-- Give up on the whole search once it expanded too many states.
+        if (_max_nodes && nodes > _max_nodes) { return ULLONG_MAX; }
+    }
+
+    return least;
+}
+
+
+bool Solver::loadPatterns() {
+
+    std::size_t disks = _board->getNumDisks();
+    std::size_t size  = this->getPatternSize();
+
+    //-- Give the largest disks, which move least, the biggest tables. The 
+    //-- smallest group needs three disks, so borrows from the one above it,
+    //-- or joins it if that one is too small to lend.
+    std::vector<std::size_t> counts;
+    for (std::size_t left = disks; left > 0; left -= counts.back()) {
+        counts.push_back(std::min(size, left));
+    }
+    if (counts.size() > 1 && counts.back() < 3) {
+        std::size_t  need  = 3 - counts.back();
+        std::size_t& above = counts[counts.size() - 2];
+        if (above >= need + 3) { above -= need; counts.back() += need; }
+        else                   { above += counts.back(); counts.pop_back(); }
+    }
+
+    std::vector<std::shared_ptr<PatternDatabase>> patterns;
+    std::vector<std::uint64_t>                    pattern_disks;
+    std::size_t top = disks;
+    for (std::size_t count : counts) {
+
+        //-- Groups of the same size share a table.
+        std::shared_ptr<PatternDatabase> pattern;
+        for (auto& other : patterns) {
+            if (other->getNumDisks() == count) { pattern = other; }
+        }
+        if (!pattern) { pattern = this->loadPattern(count); }
+        if (!pattern) { return false; }
+
+        //-- Bit (size-1) of the planes is the disk of that size.
+        std::uint64_t mask = ( count == 64 ? ~0ULL : (1ULL << count) - 1 ) << (top - count);
+        top -= count;
+
+        patterns.push_back(pattern);
+        pattern_disks.push_back(mask);
+    }
+
+    this->_patterns.swap(patterns);
+    this->_pattern_disks.swap(pattern_disks);
+    return true;
+}
+
+
+std::shared_ptr<PatternDatabase> Solver::loadPattern(std::size_t count) {
+
+    std::size_t pegs    = _board->getNumPegs();
+    bool        bicolor = _board->getIsBicolor();
+    auto        pattern = std::make_shared<PatternDatabase>(pegs, count, bicolor);
+
+    std::string file = ( _pdb_path.empty() ? "" : 
+        _pdb_path + "/" + PatternDatabase::getFileName(pegs, count, bicolor) );
+    if (!file.empty() && pattern->load(file)) { return pattern; }
+
+    if (!pattern->build()) { return nullptr; }
+    if (!file.empty() && !pattern->save(file)) {
+        std::cerr << "[warning] Could not save pattern database to " << file << std::endl;
+    }
+
+    return pattern;
+}
+
+
+std::size_t Solver::getPatternSize() {
+
+    std::size_t pegs  = _board->getNumPegs();
+    std::size_t disks = _board->getNumDisks();
+
+    //-- Take the most disks that keep a table near a million entries, and
+    //-- at least the three disks a board needs.
+    std::size_t size = _pdb_disks;
+    if (size == 0) {
+        hash_t base   = ( _board->getIsBicolor() ? (pegs * pegs) + pegs : pegs );
+        hash_t states = base;
+        while (size < disks && states <= (1ULL << 20)) { ++size; states *= base; }
+    }
+
+    return std::max<std::size_t>(std::min(size, disks), 3);
+}
+
+
+ull Solver::estimate(const BoardSnapshot& state) {
+
+    ull sum = 0;
+    for (std::size_t gdx = 0; gdx < _patterns.size(); ++gdx) {
+        sum += _patterns[gdx]->lookup(state, _pattern_disks[gdx]);
+    }
+
+    return std::max(sum, _board->getLowerBound(state));
+}
+
+
+bool Solver::searchBidirectional(hash_t start) {
+
+    //-- Already on a cached path.
+    if (_dist.find(start) != _dist.end()) { return true; }
+
+    BoardSnapshot state, goal;
+    if (!_board->setFromHashableState(start)      || !_board->saveSnapshot(state)) { return false; }
+    if (!_board->setFromHashableState(_goal_hash) || !_board->saveSnapshot(goal))  { return false; }
+
+    //-- Side 0 grows from the start and side 1 from the goal. Each reached 
+    //-- state keeps its distance from its side's root, the neighbour it was 
+    //-- reached from, and the move from that neighbour.
+    struct link {
+        ull    dist;
+        hash_t parent;
+        pii    move;
+    };
+    std::unordered_map<hash_t,link,HashHasher> reached[2];
+    std::vector<BoardSnapshot>                 frontier[2], next_frontier;
+    reached[0][start]      = { 0, start,      std::make_pair(-1,-1) };
+    reached[1][_goal_hash] = { 0, _goal_hash, std::make_pair(-1,-1) };
+    frontier[0].push_back(state);
+    frontier[1].push_back(goal);
+
+    //-- The first level where the sides meet holds a shortest path, though
+    //-- not always at the first meeting found, so the whole level is expanded
+    //-- before taking the least.
+    hash_t meet  = start;
+    ull    total = ( start == _goal_hash ? 0 : ULLONG_MAX );
+    BoardSnapshot next;
+    while (total == ULLONG_MAX && !frontier[0].empty() && !frontier[1].empty()) {
+
+        std::size_t side = ( frontier[0].size() <= frontier[1].size() ? 0 : 1 );
+        auto& mine   = reached[side];
+        auto& theirs = reached[1 - side];
+
+        next_frontier.clear();
+        for (const BoardSnapshot& cur : frontier[side]) {
+
+            ull cost = mine[cur.getHashableState()].dist + 1;
+            for (std::uint64_t legal = _board->getLegalMoves(cur); legal; legal &= legal - 1) {
+
+                std::size_t mdx = __builtin_ctzll(legal);
+                _board->applyMove(cur, _moves[mdx].first, _moves[mdx].second, next);
+
+                hash_t next_hash = next.getHashableState();
+                if (mine.find(next_hash) != mine.end()) { continue; }
+                mine[next_hash] = { cost, cur.getHashableState(), _moves[mdx] };
+                next_frontier.push_back(next);
+
+                auto other = theirs.find(next_hash);
+                if (other != theirs.end() && cost + other->second.dist < total) {
+                    total = cost + other->second.dist;
+                    meet  = next_hash;
+                }
+            }
+        }
+
+        frontier[side].swap(next_frontier);
+        if (_max_nodes && reached[0].size() + reached[1].size() > _max_nodes) { return false; }
+    }
+
+    if (total == ULLONG_MAX) { return false; }
+
+    //-- Walk back from the meeting state to the start, then forward to the
+    //-- goal, undoing the moves the goal side made.
+    std::vector<std::pair<hash_t,pii>> path;
+    for (hash_t cur = meet; cur != start; cur = reached[0][cur].parent) {
+        path.push_back(std::make_pair(reached[0][cur].parent, reached[0][cur].move));
+    }
+    std::reverse(path.begin(), path.end());
+    for (hash_t cur = meet; cur != _goal_hash; cur = reached[1][cur].parent) {
+        pii undo = std::make_pair(reached[1][cur].move.second, reached[1][cur].move.first);
+        path.push_back(std::make_pair(cur, undo));
+    }
+
+    //-- Cache the exact distance and next move of every state on the path.
+    for (std::size_t sdx = 0; sdx < path.size(); ++sdx) {
+        _dist[path[sdx].first] = total - sdx;
+        _next[path[sdx].first] = path[sdx].second;
+    }
+    _dist[_goal_hash] = 0;
+
+    return true;
+}
+
+
+bool Solver::searchQuery(hash_t start) {
+
+    if (!this->searchSingle(start)) { return false; }
+    this->searchRegion(start);
+
+    return true;
+}
 
-    for (std::size_t mdx = 1; mdx < state_moves.size(); ++mdx) {
 
-        // <REMOVE>
-        std::cout << "\t - (" << state_moves[mdx].from << "," << state_moves[mdx].to << ")  -->  " 
-                  << state_moves[mdx].dist << ":" << state_moves[mdx].hash << std::endl;
-        // <\REMOVE>
+bool Solver::searchSingle(hash_t start) {
 
+    switch (_search) {
+    case solverOptions::IDASTAR:       return this->searchIDAStar(start);
+    case solverOptions::BIDIRECTIONAL: return this->searchBidirectional(start);
+    default:                           return this->searchAStar(start);
+    }
+}
+
+
+void Solver::searchRegion(hash_t center) {
+
+    if (_local_depth == 0 || !_explored.insert(center).second) { return; }
+
+    BoardSnapshot state, next;
+    if (!_board->setFromHashableState(center) || !_board->saveSnapshot(state)) { return; }
+
+    //-- Breadth-first out from the center, so the nearest states are solved
+    //-- first if the budget runs out.
+    std::unordered_set<hash_t,HashHasher> seen;
+    std::vector<BoardSnapshot>            level(1, state), upcoming;
+    std::size_t                           searched = 0;
+    seen.insert(center);
+    for (std::size_t depth = 0; depth < _local_depth && !level.empty(); ++depth) {
+
+        upcoming.clear();
+        for (const BoardSnapshot& cur : level) {
+            for (std::uint64_t legal = _board->getLegalMoves(cur); legal; legal &= legal - 1) {
+
+                std::size_t mdx = __builtin_ctzll(legal);
+                _board->applyMove(cur, _moves[mdx].first, _moves[mdx].second, next);
+
+                hash_t hash = next.getHashableState();
+                if (!seen.insert(hash).second) { continue; }
+                upcoming.push_back(next);
+
+                if (_dist.find(hash) != _dist.end()) { continue; }
+                if (_local_states != 0 && searched >= _local_states) { return; }
+
+                searched += 1;
+                this->searchSingle(hash);
+            }
+        }
+        level.swap(upcoming);
+    }
+
+    return;
+}
+
+
+void Solver::answerAnalytic(hash_t hash, ull& dist, pii* best/*=nullptr*/) {
+
+    dist = 0;
+    if (best) { *best = std::make_pair(-1,-1); }
+    if (!_board->setFromHashableState(hash)) { return; }
+
+    //-- The classic game has a closed form for both.
+    if (!_board->getIsBicolor()) {
+        int from, to;
+        dist = _board->getLowerBound();
+        if (best && _board->getClassicMove(from, to)) { *best = std::make_pair(from, to); }
+        return;
+    }
+
+    //-- Bicolor sizes with black at the bottom of peg 0 and white at the 
+    //-- bottom of peg 1, under only larger sizes in place, never move again
+    //-- and are no obstacle to smaller disks. So peel them off from the
+    //-- largest size down, which leaves a smaller board of the sizes left.
+    BoardSnapshot state;
+    _board->saveSnapshot(state);
+
+    std::uint64_t placed = state.blacks[0] & state.whites[1];
+    std::size_t   left   = _board->getNumDisks();
+    while (left > 0 && (placed >> (left-1)) & 1) { --left; }
+    if (left == 0) { return; }
+
+    //-- The tower costs of each size are worked out on the first query.
+    if (!_bicolor_distance) {
+        _bicolor_distance = std::make_shared<BicolorDistance>(_board->getNumDisks());
+    }
+    if (!best) {
+        dist = _bicolor_distance->getDistance(state, left);
+        return;
+    }
+
+    //-- A move of a size set aside only ever takes longer.
+    int from, to;
+    if (_bicolor_distance->getBestMove(state, left, from, to, &dist)) { *best = std::make_pair(from, to); }
+}
+
+
+bool Solver::findDistance(const BoardSnapshot& state, ull& dist) {
+
+    if (_storage == MAPPED) {
+        return _mapped_table->lookup(_board->getRankedState(state), dist);
+    }
+
+    if (_storage == FLAT) {
+        std::uint32_t entry = _table.empty() ? UINT32_MAX : _table[_board->getRankedState(state)];
+        dist = entry;
+        return entry != UINT32_MAX;
+    }
+
+    if (_storage == DISK) {
+        return _disk_table->lookup(_board->getRankedState(state), dist);
+    }
+
+    std::vector<std::size_t> pegs;
+    hash_t key = ( _storage == CANONICAL ? _board->getCanonicalState(state, pegs) : state.getHashableState() );
+    auto it = _dist.find(key);
+    if (it == _dist.end()) { return false; }
+
+    dist = it->second;
+    return true;
+}
+
+
+void Solver::generateMoves(const BoardSnapshot& state, mvec& state_moves) {
+
+    state_moves.clear();
+
+    BoardSnapshot next;
+    for (std::uint64_t legal = _board->getLegalMoves(state); legal; legal &= legal - 1) {
+
+        std::size_t mdx = __builtin_ctzll(legal);
+        _board->applyMove(state, _moves[mdx].first, _moves[mdx].second, next);
+
+        move current_move;
+        current_move.from = _moves[mdx].first;
+        current_move.to   = _moves[mdx].second;
+        current_move.hash = next.getHashableState();
+        if (!this->findDistance(next, current_move.dist)) { continue; }
+
+        state_moves.push_back(current_move);
+    }
+
+    return;
+}
+
+
+hash_t Solver::lookupKey(hash_t hash) {
+
+    if (_storage != CANONICAL || !_board->setFromHashableState(hash)) { return hash; }
+
+    std::vector<std::size_t> pegs;
+    return _board->getCanonicalState(pegs);
+}
+
+
+pii Solver::getBestMove(hash_t hash) {
+
+    //-- Closed form answers work from the state alone.
+    if (_search == solverOptions::ANALYTIC) {
+        ull dist;
+        pii best;
+        this->answerAnalytic(hash, dist, &best);
+        return best;
+    }
+
+    //-- Single query searches answer from the path through the state.
+    if (_search != solverOptions::BFS) {
+        if (!this->searchQuery(hash)) { return std::make_pair(-1,-1); }
+        auto it = _next.find(hash);
+        return ( it == _next.end() ? std::make_pair(-1,-1) : it->second );
+    }
+
+    //-- Mapped tables hold the move already picked.
+    if (_storage == MAPPED) {
+        std::size_t mdx;
+        if (!_mapped_table->getBestMove(_board->hashToRank(hash), mdx)) { return std::make_pair(-1,-1); }
+        return _moves[mdx];
+    }
+
+    //-- Boards too wide for a legal move mask pick from the stored moves.
+    BoardSnapshot cur, next;
+    if (!_board->setFromHashableState(hash) || !_board->saveSnapshot(cur)) {
+        return this->getStoredBestMove(hash);
+    }
+
+    //-- Walk the legal moves and take the first that ends up closest to the goal.
+    pii best = std::make_pair(-1,-1);
+    ull best_dist = 0;
+    for (std::uint64_t legal = _board->getLegalMoves(cur); legal; legal &= legal - 1) {
+
+        std::size_t mdx = __builtin_ctzll(legal);
+        _board->applyMove(cur, _moves[mdx].first, _moves[mdx].second, next);
+
+        ull dist;
+        if (!this->findDistance(next, dist)) { continue; }
+
+        if (best.first < 0 || dist < best_dist) {
+            best      = _moves[mdx];
+            best_dist = dist;
+        }
+    }
+
+    return best;
+}
+
+
+pii Solver::getStoredBestMove(hash_t hash) {
+
+    auto it = _sssp.find(hash);
+    if (it == _sssp.end()) { return std::make_pair(-1,-1); }
+    const mvec& state_moves = it->second;
+
+    std::size_t min_idx = 0;
+    for (std::size_t mdx = 1; mdx < state_moves.size(); ++mdx) {
         if (state_moves[min_idx].dist > state_moves[mdx].dist) {
             min_idx = mdx;
         }
@@ -177,8 +1179,37 @@ pii Solver::getBestMove(ull hash) {
 }
 
 
-ull Solver::getDistance(ull hash) {
-    return _dist[hash];
+ull Solver::getDistance(hash_t hash) {
+
+    //-- Unreached or invalid states are reported as distance 0.
+    if (_search == solverOptions::ANALYTIC) {
+        ull dist;
+        this->answerAnalytic(hash, dist);
+        return dist;
+    }
+
+    if (_search != solverOptions::BFS) {
+        if (!this->searchQuery(hash)) { return 0; }
+        return _dist[hash];
+    }
+
+    if (_storage == FLAT) {
+        hash_t rank = _board->hashToRank(hash);
+        if (rank >= _table.size() || _table[rank] == UINT32_MAX) { return 0; }
+        return _table[rank];
+    }
+
+    if (_storage == DISK) {
+        ull dist;
+        return ( _disk_table->lookup(_board->hashToRank(hash), dist) ? dist : 0 );
+    }
+
+    if (_storage == MAPPED) {
+        ull dist;
+        return ( _mapped_table->lookup(_board->hashToRank(hash), dist) ? dist : 0 );
+    }
+
+    return _dist[this->lookupKey(hash)];
 }
 
 
@@ -197,28 +1228,50 @@ std::string Solver::flushSolution() {
         tabx1 + "},\n";
 
     ret += tabx1 + "{\n" + 
-        tabx2 + "\"start\": \"" + std::to_string(_start_hash) + "\",\n" +
-        tabx2 + "\"goal\":  \"" + std::to_string(_goal_hash)  + "\"\n"  +
+        tabx2 + "\"start\": \"" + hashToString(_start_hash) + "\",\n" +
+        tabx2 + "\"goal\":  \"" + hashToString(_goal_hash)  + "\"\n"  +
         tabx1 + "},\n";
 
-    ret += tabx1 + "{\n";
-    for (auto it = _sssp.begin(); it != _sssp.end(); ++it) {
+    //-- Write out one state and its moves.
+    bool first = true;
+    auto writeState = [&](hash_t state, const mvec& state_moves) {
 
-        if (it != _sssp.begin()) { ret += ",\n"; }
+        if (!first) { ret += ",\n"; }
+        first = false;
         
-        ret += tabx2 + "\"" + std::to_string(it->first) + "\": {\n";
+        ret += tabx2 + "\"" + hashToString(state) + "\": {\n";
 
-        mvec state_moves = it->second;
         for (std::size_t mdx = 0; mdx < state_moves.size(); ++mdx) {
             if (mdx) { ret += ",\n"; }
             ret += tabx3 + "\"(" + 
                 std::to_string(state_moves[mdx].from) + "," +
                 std::to_string(state_moves[mdx].to) + ")\": { \"hash\": \"" +
-                std::to_string(state_moves[mdx].hash) + "\", \"dist\": \"" + 
+                hashToString(state_moves[mdx].hash) + "\", \"dist\": \"" + 
                 std::to_string(state_moves[mdx].dist) + "\" }";
         }
 
         ret += "\n" + tabx2 + "}";
+    };
+
+    ret += tabx1 + "{\n";
+    if (_storage == FLAT || _storage == DISK || _storage == MAPPED) {
+
+        //-- Moves are regenerated for every reached rank.
+        BoardSnapshot state;
+        mvec          state_moves;
+        ull           dist;
+        for (hash_t rank = 0; rank < _board->getNumStates(); ++rank) {
+            if (_storage == FLAT && (rank >= _table.size() || _table[rank] == UINT32_MAX)) { continue; }
+            if (_storage == DISK && !_disk_table->lookup(rank, dist))                      { continue; }
+            if (_storage == MAPPED && !_mapped_table->lookup(rank, dist))                  { continue; }
+            _board->getSnapshotFromRank(rank, state);
+            this->generateMoves(state, state_moves);
+            writeState(state.getHashableState(), state_moves);
+        }
+    } else {
+        for (auto it = _sssp.begin(); it != _sssp.end(); ++it) {
+            writeState(it->first, it->second);
+        }
     }
     ret += "\n" + tabx1 + "}\n";
     ret += "]";
@@ -10,10 +10,13 @@
  * ================================================================================
  */
 
+#include <algorithm>
+#include <cstdlib>
 #include <iostream>
 #include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <iosPlayer.hpp>
 #include <game.hpp>
@@ -32,7 +35,7 @@ int main (int argc, char **argv) {
 
     //-- Init and configure the game.
     Game tower(player);
-    tower.configure(conf);
+    if (!tower.configure(conf)) { return EXIT_FAILURE; }
     
     //-- Run the game and return its status.
     return tower.run();
@@ -45,5 +48,26 @@ std::map<std::string,std::string> getArgs(int argc, char **argv) {
     std::map<std::string,std::string> dict;
     dict.clear();
 
+    //-- Settings are given as --key value, or just --key to set it to 1.
+    const std::vector<std::string>& keys = Game::getConfKeys();
+    for (int adx = 1; adx < argc; ++adx) {
+
+        std::string arg = argv[adx];
+        if (arg.rfind("--", 0) != 0) {
+            std::cerr << "[warning] Ignoring argument " << arg << "." << std::endl;
+            continue;
+        }
+
+        std::string key = arg.substr(2);
+        std::string value = "1";
+        if (adx + 1 < argc && std::string(argv[adx+1]).rfind("--", 0) != 0) { value = argv[++adx]; }
+
+        if (std::find(keys.begin(), keys.end(), key) == keys.end()) {
+            std::cerr << "[warning] Ignoring unknown setting --" << key << "." << std::endl;
+            continue;
+        }
+        dict[key] = value;
+    }
+
     return dict;
 }
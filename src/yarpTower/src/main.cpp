@@ -18,6 +18,7 @@
 #include <yarp/os/Network.h>
 #include <yarp/os/LogStream.h>
 #include <yarp/os/ResourceFinder.h>
+#include <yarp/os/Value.h>
 
 #include <yarpPlayer.hpp>
 #include <game.hpp>
@@ -43,7 +44,7 @@ int main (int argc, char **argv) {
 
     //-- Init and configure the game.
     Game tower(player);
-    tower.configure(conf);
+    if (!tower.configure(conf)) { return EXIT_FAILURE; }
     
     //-- Run the game and return its status.
     return tower.run();
@@ -63,9 +64,13 @@ std::map<std::string,std::string> getArgs(int argc, char **argv) {
     rf.setDefaultContext("yarp_tower");     // overridden by --context parameter
     rf.configure(argc,argv);
 
-    //-- Set important variables from rf into the dict.
-    //
-    //
+    //-- Set important variables from rf into the dict, from either the
+    //-- command line or the config file.
+    for (const std::string& key : Game::getConfKeys()) {
+        if (!rf.check(key)) { continue; }
+        yarp::os::Value& value = rf.find(key);
+        dict[key] = ( value.isString() ? value.asString() : value.toString() );
+    }
 
     return dict;
 }
@@ -10,8 +10,11 @@
  * ================================================================================
  */
 
+#include <algorithm>
 #include <iostream>
 #include <board.hpp>
+#include <fixedBoard.hpp>
+#include <hashBatch.hpp>
 #include <gtest/gtest.h>
 
 /*
@@ -27,7 +30,7 @@ TEST(BoardTest, BasicAssertions) {
 //
 // Helper function.
 //
-void printState(std::vector<std::vector<Disk>> state) {
+void printState(const std::vector<std::vector<Disk>>& state) {
     std::cout << ">>>" << std::endl;
     for (auto p : state) {
         for (auto d : p) {
@@ -79,6 +82,29 @@ TEST(BoardTest, BoardConstructor_Parameter3) {
     EXPECT_FALSE(b.init());
 
 }
+TEST(BoardTest, BoardConstructor_HashLimit) {
+
+    // Bounded by what fits in a hash, not by a fixed number of disks.
+    Board mono(/*pegs=*/3, /*disks=*/21);
+    EXPECT_TRUE(mono.init());
+    EXPECT_EQ(mono.getHashableState(), mono.rankToHash(mono.getRankedState()));
+    EXPECT_TRUE(mono.setFromHashableState(mono.getHashableGoal()));
+    EXPECT_TRUE(mono.isGoal());
+
+    Board bicolor(/*pegs=*/3, /*disks=*/9, /*isBicolor=*/true);
+    EXPECT_TRUE(bicolor.init());
+    EXPECT_EQ(bicolor.getHashableState(), bicolor.rankToHash(bicolor.getRankedState()));
+
+    Board large(/*pegs=*/6, /*disks=*/6, /*isBicolor=*/true);
+#ifdef TOWER_OF_HANOI_WIDE_HASH
+    EXPECT_TRUE(large.init());
+    EXPECT_TRUE(large.setFromHashableState(large.getHashableGoal()));
+    EXPECT_TRUE(large.isGoal());
+#else
+    EXPECT_FALSE(large.init());
+#endif
+
+}
 
 
 //
@@ -92,7 +118,7 @@ TEST(BoardTest, BoardMove_Mono) {
     EXPECT_FALSE(b.getIsBicolor());
     EXPECT_TRUE(b.init());
 
-    //std::cout << "Board hash: " << b.getHashableState() << std::endl;
+    //std::cout << "Board hash: " << hashToString(b.getHashableState()) << std::endl;
     //printState(b.getRawState());
 
     // Make some legal moves.
@@ -100,7 +126,7 @@ TEST(BoardTest, BoardMove_Mono) {
     EXPECT_TRUE(b.move(0, 2));
     EXPECT_TRUE(b.move(0, 3));
 
-    //std::cout << "Board hash: " << b.getHashableState() << std::endl;
+    //std::cout << "Board hash: " << hashToString(b.getHashableState()) << std::endl;
     //printState(b.getRawState());
 
     // Make a few bad moves.
@@ -118,7 +144,7 @@ TEST(BoardTest, BoardMove_Mono) {
     // Try an empty peg move.
     EXPECT_FALSE(b.move(0, 3));
 
-    //std::cout << "Board hash: " << b.getHashableState() << std::endl;
+    //std::cout << "Board hash: " << hashToString(b.getHashableState()) << std::endl;
     //printState(b.getRawState());
 
 }
@@ -130,7 +156,7 @@ TEST(BoardTest, BoardMove_Bicolor) {
     EXPECT_TRUE(b.getIsBicolor());
     EXPECT_TRUE(b.init());
 
-    std::cout << "Board hash: " << b.getHashableState() << std::endl;
+    std::cout << "Board hash: " << hashToString(b.getHashableState()) << std::endl;
     printState(b.getRawState());
 
     // Make some legal moves.
@@ -144,7 +170,7 @@ TEST(BoardTest, BoardMove_Bicolor) {
     EXPECT_FALSE(b.move(2, 0));
     EXPECT_FALSE(b.move(0, 1));
 
-    std::cout << "Board hash: " << b.getHashableState() << std::endl;
+    std::cout << "Board hash: " << hashToString(b.getHashableState()) << std::endl;
     printState(b.getRawState());
 
     // Make some legal moves.
@@ -153,7 +179,7 @@ TEST(BoardTest, BoardMove_Bicolor) {
     EXPECT_TRUE(b.move(1, 2));
     EXPECT_TRUE(b.move(1, 0));
 
-    std::cout << "Board hash: " << b.getHashableState() << std::endl;
+    std::cout << "Board hash: " << hashToString(b.getHashableState()) << std::endl;
     printState(b.getRawState());
 
 }
@@ -167,7 +193,10 @@ TEST(BoardTest, BoardGetHashableState_Mono) {
     Board b(/*pegs=*/4, /*disks=*/3, /*isBicolor=*/false);
     EXPECT_TRUE(b.init());
     
-    unsigned long long h = b.getHashableState();
+    hash_t h = b.getHashableState();
+    EXPECT_NE(b.getHashableGoal(), h);
+    EXPECT_TRUE(b.setFromHashableState(h));
+    EXPECT_EQ(h, b.getHashableState());
     printState(b.getRawState());
 
 }
@@ -176,7 +205,10 @@ TEST(BoardTest, BoardGetHashableState_Bicolor) {
     Board b(/*pegs=*/3, /*disks=*/4, /*isBicolor=*/true);
     EXPECT_TRUE(b.init());
 
-    unsigned long long h = b.getHashableState();
+    hash_t h = b.getHashableState();
+    EXPECT_NE(b.getHashableGoal(), h);
+    EXPECT_TRUE(b.setFromHashableState(h));
+    EXPECT_EQ(h, b.getHashableState());
     printState(b.getRawState());
 
 }
@@ -187,8 +219,39 @@ TEST(BoardTest, BoardGetHashableState_Bicolor) {
 //
 TEST(BoardTest, BoardSetFromHashableState_Mono) {
 
+    Board b(/*pegs=*/3, /*disks=*/4, /*isBicolor=*/false);
+    EXPECT_TRUE(b.init());
+
+    std::vector<std::size_t> state;
+    unsigned long long hash;
+
+    // Board State
+    //                            
+    //                            
+    //        [OOO]               [O]
+    //        [OOOO]              [OO]
+    state = { 1,1,0,0,  0,0,0,0,  0,0,1,1 };
+    hash  = b.computeHash(state);
+
+    EXPECT_TRUE(b.setFromHashableState(hash));
+    EXPECT_EQ(hash, b.getHashableState());
+
+    // Smallest disk can go onto the middle peg, the next cannot follow it.
+    EXPECT_TRUE(b.move(2, 1));
+    EXPECT_FALSE(b.move(2, 1));
+    EXPECT_FALSE(b.move(0, 1));
+    EXPECT_EQ(b.computeHash({ 1,1,0,0,  0,0,0,1,  0,0,1,0 }), b.getHashableState());
+
+    printState(b.getRawState());
 
 
+    // Board State (two of the largest disk, none of the smallest)
+    state = { 1,1,0,0,  1,0,0,0,  0,0,1,0 };
+    hash  = b.computeHash(state);
+
+    EXPECT_FALSE(b.setFromHashableState(hash));
+    EXPECT_EQ(b.computeHash({ 1,1,0,0,  0,0,0,1,  0,0,1,0 }), b.getHashableState());
+
 }
 TEST(BoardTest, BoardSetFromHashableState_Bicolor) {
 
@@ -247,6 +310,30 @@ TEST(BoardTest, BoardSetFromHashableState_Bicolor) {
 //
 TEST(BoardTest, BoardGetShowableState_Mono) {
 
+    Board b(/*pegs=*/3, /*disks=*/3);
+    EXPECT_TRUE(b.init());
+
+    // Rows are drawn top down, above the base and the peg labels.
+    std::string start = b.getShowableState();
+    EXPECT_EQ(0, start.find("\n      \u2502        \u2502        \u2502   \n"));
+    EXPECT_NE(std::string::npos, start.find("     [0]      [1]      [2]    \n"));
+
+    // Drawings are cached by state, and stay correct across moves.
+    EXPECT_EQ(start, b.getShowableState());
+    EXPECT_TRUE(b.move(0, 1));
+    EXPECT_NE(start, b.getShowableState());
+    EXPECT_TRUE(b.move(1, 0));
+    EXPECT_EQ(start, b.getShowableState());
+
+    // The goal state draws the same as the goal.
+    EXPECT_TRUE(b.setFromHashableState(b.getHashableGoal()));
+    EXPECT_EQ(b.getShowableGoal(), b.getShowableState());
+
+    // New settings draw at the new size.
+    b.setNumDisks(4);
+    EXPECT_TRUE(b.init());
+    EXPECT_NE(start.size(), b.getShowableState().size());
+
 }
 TEST(BoardTest, BoardGetShowableState_Bicolor) {
 
@@ -269,3 +356,359 @@ TEST(BoardTest, BoardGetShowableState_Bicolor) {
     std::cout << b.getShowableState() << std::endl << std::endl;
 
 }
+
+
+//
+// BoardTest_BoardTracking
+//
+TEST(BoardTest, BoardTracking_Mono) {
+
+    Board b(/*pegs=*/4, /*disks=*/5);
+    EXPECT_TRUE(b.init());
+    EXPECT_EQ(5, b.getNumMisplaced());
+    EXPECT_FALSE(b.isGoal());
+
+    // Hash kept by the moves has to match one computed from scratch.
+    for (int idx = 0; idx < 500; ++idx) {
+        if (b.move(idx % 4, (idx * 7 + 1) % 4)) {
+            EXPECT_EQ(b.computeHash(b.generateEncoding(b.getRawState())), b.getHashableState());
+        }
+    }
+
+    // Jumping to the goal resets the tracking.
+    EXPECT_TRUE(b.setFromHashableState(b.getHashableGoal()));
+    EXPECT_EQ(0, b.getNumMisplaced());
+    EXPECT_TRUE(b.isGoal());
+
+    EXPECT_TRUE(b.move(3, 0));
+    EXPECT_EQ(1, b.getNumMisplaced());
+    EXPECT_FALSE(b.isGoal());
+
+}
+TEST(BoardTest, BoardTracking_Bicolor) {
+
+    Board b(/*pegs=*/3, /*disks=*/4, /*isBicolor=*/true);
+    EXPECT_TRUE(b.init());
+    EXPECT_EQ(4, b.getNumMisplaced());
+
+    for (int idx = 0; idx < 500; ++idx) {
+        if (b.move(idx % 3, (idx * 5 + 1) % 3)) {
+            EXPECT_EQ(b.computeHash(b.generateEncoding(b.getRawState())), b.getHashableState());
+        }
+    }
+
+    // Same-size pairs on both sides of a move.
+    //                            
+    //        [X]                 [O]
+    //        [OOOO]    [XXX]     [XX]
+    //        [XXXX]    [OOO]     [OO]
+    std::vector<std::size_t> state = { 3,0,0,1,  0,4,0,0,  0,0,4,2 };
+    EXPECT_TRUE(b.setFromHashableState(b.computeHash(state)));
+    EXPECT_TRUE(b.move(2, 0));
+    EXPECT_EQ(b.computeHash({ 3,0,0,3,  0,4,0,0,  0,0,4,0 }), b.getHashableState());
+    EXPECT_TRUE(b.move(0, 1));
+    EXPECT_EQ(b.computeHash({ 3,0,0,1,  0,4,0,2,  0,0,4,0 }), b.getHashableState());
+
+    EXPECT_TRUE(b.setFromHashableState(b.getHashableGoal()));
+    EXPECT_TRUE(b.isGoal());
+
+}
+
+
+//
+// BoardTest_BoardViewRawState
+//
+TEST(BoardTest, BoardViewRawState) {
+
+    Board b(/*pegs=*/3, /*disks=*/3, /*isBicolor=*/false);
+    EXPECT_TRUE(b.init());
+
+    // The view follows the board without being copied.
+    const std::vector<std::vector<Disk>>& view = b.viewRawState();
+    EXPECT_EQ(3, view[0].size());
+    EXPECT_TRUE(b.move(0, 2));
+    EXPECT_EQ(&view, &b.viewRawState());
+    EXPECT_EQ(2, view[0].size());
+    EXPECT_EQ(1, view[2].size());
+    EXPECT_EQ(1, view[2][0].getSize());
+
+    EXPECT_EQ(3, b.viewRawGoal()[2].size());
+    EXPECT_EQ(b.getHashableState(), b.computeHash(b.generateEncoding(view)));
+
+}
+
+//
+// BoardTest_BoardRankedState
+//
+TEST(BoardTest, BoardRankedState_Mono) {
+
+    Board b(/*pegs=*/4, /*disks=*/3, /*isBicolor=*/false);
+    EXPECT_TRUE(b.init());
+    EXPECT_EQ(64, b.getNumStates());
+
+    // Every rank maps to a distinct valid hash and back.
+    for (unsigned long long rank = 0; rank < b.getNumStates(); ++rank) {
+        unsigned long long hash = b.rankToHash(rank);
+        EXPECT_EQ(rank, b.hashToRank(hash));
+        EXPECT_TRUE(b.setFromRankedState(rank));
+        EXPECT_EQ(hash, b.getHashableState());
+        EXPECT_EQ(rank, b.getRankedState());
+    }
+
+    EXPECT_FALSE(b.setFromRankedState(b.getNumStates()));
+    EXPECT_EQ(b.getNumStates(), b.hashToRank(b.computeHash({ 1,1,0,  1,0,0,  0,0,1,  0,0,0 })));
+
+}
+TEST(BoardTest, BoardRankedState_Bicolor) {
+
+    Board b(/*pegs=*/3, /*disks=*/3, /*isBicolor=*/true);
+    EXPECT_TRUE(b.init());
+    EXPECT_EQ(1728, b.getNumStates());
+
+    for (unsigned long long rank = 0; rank < b.getNumStates(); ++rank) {
+        unsigned long long hash = b.rankToHash(rank);
+        EXPECT_EQ(rank, b.hashToRank(hash));
+        EXPECT_TRUE(b.setFromRankedState(rank));
+        EXPECT_EQ(hash, b.getHashableState());
+    }
+
+    // Two black disks of the largest size.
+    EXPECT_EQ(b.getNumStates(), b.hashToRank(b.computeHash({ 1,1,1,  1,2,2,  0,0,0 })));
+
+}
+
+
+//
+// BoardTest_FixedBoard
+//
+template<std::size_t Pegs, std::size_t Disks, bool Bicolor>
+void checkFixedBoard() {
+
+    // The fixed board has to agree with the runtime board on every step.
+    Board b(Pegs, Disks, Bicolor);
+    FixedBoard<Pegs, Disks, Bicolor> f;
+    EXPECT_TRUE(b.init());
+    EXPECT_TRUE(f.init());
+    EXPECT_EQ(b.getHashableState(), f.getHashableState());
+    EXPECT_EQ(b.getHashableGoal(),  f.getHashableGoal());
+
+    for (int idx = 0; idx < 500; ++idx) {
+        int from = idx % Pegs, to = (idx * 7 + 1) % Pegs;
+        EXPECT_EQ(b.move(from, to), f.move(from, to));
+        EXPECT_EQ(b.getHashableState(), f.getHashableState());
+        EXPECT_EQ(b.isGoal(), f.isGoal());
+    }
+
+    EXPECT_TRUE(f.setFromHashableState(f.getHashableGoal()));
+    EXPECT_TRUE(f.isGoal());
+    EXPECT_EQ(f.getHashableGoal(), f.getHashableState());
+
+}
+TEST(BoardTest, FixedBoard_Mono) {
+    checkFixedBoard<4, 5, false>();
+}
+TEST(BoardTest, FixedBoard_Bicolor) {
+    checkFixedBoard<3, 4, true>();
+
+    // Two black disks of the largest size.
+    FixedBoard<3, 3, true> f;
+    EXPECT_TRUE(f.init());
+    Board b(3, 3, true);
+    EXPECT_FALSE(f.setFromHashableState(b.computeHash({ 1,1,1,  1,2,2,  0,0,0 })));
+}
+TEST(BoardTest, FixedBoard_Dispatch) {
+
+    std::size_t pegs = 0, disks = 0;
+    bool bicolor = false;
+    auto visitor = [&](auto& board) {
+        pegs    = board.getNumPegs();
+        disks   = board.getNumDisks();
+        bicolor = board.getIsBicolor();
+    };
+
+    EXPECT_TRUE(dispatchFixedBoard(5, 3, true, visitor));
+    EXPECT_EQ(5, pegs);
+    EXPECT_EQ(3, disks);
+    EXPECT_TRUE(bicolor);
+
+    EXPECT_TRUE(dispatchFixedBoard(3, 6, false, visitor));
+    EXPECT_EQ(3, pegs);
+    EXPECT_EQ(6, disks);
+    EXPECT_FALSE(bicolor);
+
+    // Outside of the instantiated range.
+    EXPECT_FALSE(dispatchFixedBoard(3, 7, false, visitor));
+    EXPECT_FALSE(dispatchFixedBoard(2, 3, false, visitor));
+
+}
+
+
+//
+// BoardTest_BoardPackedPairs
+//
+TEST(BoardTest, BoardPackedPairs_Bicolor) {
+
+    Board b(/*pegs=*/3, /*disks=*/3, /*isBicolor=*/true);
+    EXPECT_TRUE(b.init());
+
+    // Both orders of a same size pair survive a round trip through the hash.
+    //        [X]       
+    //        [O]       [XX]       
+    //        [XXX]     [OO]      [OOO]
+    EXPECT_TRUE(b.setFromHashableState(b.computeHash({ 1,0,4,  0,4,0,  2,0,0 })));
+    const std::vector<std::vector<Disk>>& view = b.viewRawState();
+    EXPECT_EQ(3, view[0].size());
+    EXPECT_EQ(1, view[0][1].getColor());
+    EXPECT_EQ(0, view[0][2].getColor());
+    EXPECT_EQ(1, view[1][0].getColor());
+    EXPECT_EQ(0, view[1][1].getColor());
+
+    // Black on top of the pair leaves first, then white may follow it.
+    EXPECT_TRUE(b.move(0, 1));
+    EXPECT_EQ(b.computeHash({ 1,0,2,  0,4,1,  2,0,0 }), b.getHashableState());
+    EXPECT_TRUE(b.move(0, 1));
+    EXPECT_EQ(b.computeHash({ 1,0,0,  0,4,3,  2,0,0 }), b.getHashableState());
+    EXPECT_EQ(1, b.viewRawState()[1][3].getColor());
+
+    // Nothing smaller than the pair may go under it.
+    EXPECT_FALSE(b.move(0, 1));
+
+}
+
+
+//
+// BoardTest_BoardSnapshot
+//
+TEST(BoardTest, BoardSnapshot_Bicolor) {
+
+    Board b(/*pegs=*/3, /*disks=*/4, /*isBicolor=*/true);
+    EXPECT_TRUE(b.init());
+
+    BoardSnapshot start, next;
+    EXPECT_TRUE(b.saveSnapshot(start));
+    EXPECT_EQ(b.getHashableState(), start.getHashableState());
+
+    // Moving a snapshot leaves the board alone, and agrees with moving the board.
+    for (int from = 0; from < 3; ++from) {
+        for (int to = 0; to < 3; ++to) {
+
+            bool legal = b.applyMove(start, from, to, next);
+            EXPECT_EQ(start.getHashableState(), b.getHashableState());
+            if (!legal) {
+                EXPECT_EQ(start.getHashableState(), next.getHashableState());
+                continue;
+            }
+
+            EXPECT_TRUE(b.move(from, to));
+            EXPECT_EQ(b.getHashableState(), next.getHashableState());
+            EXPECT_EQ(b.getNumMisplaced(), next.misplaced);
+            EXPECT_TRUE(b.loadSnapshot(start));
+        }
+    }
+
+    // Restoring a snapshot brings back the raw state too.
+    EXPECT_TRUE(b.applyMove(start, 0, 2, next));
+    EXPECT_TRUE(b.loadSnapshot(next));
+    EXPECT_EQ(1, b.viewRawState()[2].size());
+    EXPECT_EQ(b.computeHash(b.generateEncoding(b.viewRawState())), b.getHashableState());
+
+    // Boards wider than a snapshot cannot be saved.
+    Board wide(/*pegs=*/BoardSnapshot::MAX_PEGS + 1, /*disks=*/3);
+    EXPECT_TRUE(wide.init());
+    EXPECT_FALSE(wide.saveSnapshot(start));
+
+}
+
+
+//
+// BoardTest_BoardBatchHashes
+//
+TEST(BoardTest, BoardBatchHashes) {
+
+    // A batch has to agree with converting each state on its own, including
+    // a count that leaves a few states after the last full vector.
+    for (bool bicolor : { false, true }) {
+        Board b(/*pegs=*/4, /*disks=*/5, bicolor);
+        EXPECT_TRUE(b.init());
+
+        std::vector<hash_t> hashes;
+        for (hash_t rank = 0; rank < 1000; rank += 7) {
+            hashes.push_back(b.rankToHash(rank));
+        }
+
+        std::vector<std::size_t> encodings;
+        b.generateEncodings(hashes, encodings);
+        EXPECT_EQ(hashes.size() * 20, encodings.size());
+        for (std::size_t sdx = 0; sdx < hashes.size(); ++sdx) {
+            std::vector<std::size_t> single = b.generateEncoding(hashes[sdx]);
+            EXPECT_TRUE(std::equal(single.begin(), single.end(), encodings.begin() + (sdx * 20)));
+        }
+
+        std::vector<hash_t> round_trip;
+        b.computeHashes(encodings, round_trip);
+        EXPECT_EQ(hashes, round_trip);
+    }
+
+    // Bicolor hashes of 27 slots use the full 64 bits, so check the chunk
+    // split near every multiple of 5^13 and at the top of the range.
+    std::vector<hash_t> hashes = { 0, ~0ULL, 7450580596923828124ULL };
+    for (unsigned long long cdx = 1; cdx < 40; ++cdx) {
+        unsigned long long chunk = cdx * 1220703125ULL * ( cdx < 20 ? 1 : 1220703125ULL );
+        hashes.push_back(chunk - 1);
+        hashes.push_back(chunk);
+        hashes.push_back(chunk + 1);
+    }
+    for (unsigned long long seed = 88172645463325252ULL, sdx = 0; sdx < 64; ++sdx) {
+        seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17;
+        hashes.push_back(seed);
+    }
+
+    std::vector<std::size_t> digits(hashes.size() * 27);
+    decodeHashes(hashes.data(), hashes.size(), 27, 5, digits.data());
+    for (std::size_t sdx = 0; sdx < hashes.size(); ++sdx) {
+        hash_t hash = hashes[sdx];
+        for (std::size_t edx = 0; edx < 27; ++edx, hash /= 5) {
+            EXPECT_EQ((std::size_t)(hash % 5), digits[(sdx * 27) + edx]);
+        }
+    }
+
+}
+
+
+//
+// BoardTest_BoardLegalMoves
+//
+TEST(BoardTest, BoardLegalMoves) {
+
+    // The mask has exactly the moves that Board::move accepts.
+    for (bool bicolor : { false, true }) {
+        Board b(/*pegs=*/4, /*disks=*/3, bicolor);
+        EXPECT_TRUE(b.init());
+
+        for (hash_t rank = 0; rank < b.getNumStates(); rank += 3) {
+            hash_t hash = b.rankToHash(rank);
+            EXPECT_TRUE(b.setFromHashableState(hash));
+            std::uint64_t legal = b.getLegalMoves();
+
+            BoardSnapshot cur;
+            EXPECT_TRUE(b.saveSnapshot(cur));
+            EXPECT_EQ(legal, b.getLegalMoves(cur));
+
+            for (int from = 0; from < 4; ++from) {
+                for (int to = 0; to < 4; ++to) {
+                    if (from == to) { continue; }
+
+                    std::size_t index = b.getMoveIndex(from, to);
+                    int from_back, to_back;
+                    b.getMoveFromIndex(index, from_back, to_back);
+                    EXPECT_EQ(from, from_back);
+                    EXPECT_EQ(to,   to_back);
+
+                    EXPECT_EQ(((legal >> index) & 1) == 1, b.move(from, to));
+                    EXPECT_TRUE(b.setFromHashableState(hash));
+                }
+            }
+        }
+    }
+
+}
@@ -10,8 +10,15 @@
  * ================================================================================
  */
 
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <thread>
+#include <unistd.h>
 #include <solver.hpp>
+#include <solutionSequence.hpp>
 #include <gtest/gtest.h>
 
 /*
@@ -25,6 +32,38 @@ TEST(SolverTest, TempTest) {
 */
 
 
+//-- Check a solver against a plain breadth-first search of the same board:
+//-- every state has the same distance, and every hint leads one step closer.
+static void expectMatchesReference(Solver& solver, std::size_t pegs, std::size_t disks, bool bicolor) {
+
+    Board  b(pegs, disks, bicolor);
+    Solver full(pegs, disks, bicolor);
+    EXPECT_TRUE(b.init());
+    full.solve();
+
+    for (hash_t rank = 0; rank < b.getNumStates(); ++rank) {
+        hash_t hash = b.rankToHash(rank);
+        ull    dist = full.getDistance(hash);
+
+        EXPECT_EQ(dist, solver.getDistance(hash));
+        if (dist == 0) { continue; }
+
+        pii hint = solver.getBestMove(hash);
+        EXPECT_TRUE(b.setFromHashableState(hash));
+        EXPECT_TRUE(b.move(hint.first, hint.second));
+        EXPECT_EQ(dist - 1, full.getDistance(b.getHashableState()));
+    }
+}
+
+
+static void expectMatchesReference(std::size_t pegs, std::size_t disks, bool bicolor, const solverOptions& options) {
+
+    Solver solver(pegs, disks, bicolor, options);
+    solver.solve();
+    expectMatchesReference(solver, pegs, disks, bicolor);
+}
+
+
 //
 // SolverTest_SolverConstructor
 //
@@ -54,3 +93,595 @@ TEST(SolverTest, SolverFlushSolution) {
     //EXPECT_FALSE(b.getIsBicolor());
     //EXPECT_TRUE(b.init());
 }
+
+
+//
+// SolverTest_SolverDistance
+//
+TEST(SolverTest, SolverDistance_Mono) {
+
+    // Classic puzzle takes 2^n - 1 moves, solved with a fixed board (5)
+    // and with the runtime board (7).
+    for (std::size_t disks : { 5, 7 }) {
+        Board b(/*pegs=*/3, disks);
+        EXPECT_TRUE(b.init());
+
+        Solver s(/*pegs=*/3, disks);
+        s.solve();
+        EXPECT_EQ((1ULL << disks) - 1, s.getDistance(b.getHashableState()));
+        EXPECT_EQ(0, s.getDistance(b.getHashableGoal()));
+    }
+
+}
+
+
+TEST(SolverTest, SolverDistance_ManyPegs) {
+
+    // With more pegs than disks, n disks take 2n - 1 moves. Searched with
+    // runtime board snapshots (7) and through hashes when too wide for one (9).
+    for (std::size_t pegs : { 7, 9 }) {
+        Board b(pegs, /*disks=*/3);
+        EXPECT_TRUE(b.init());
+
+        Solver s(pegs, /*disks=*/3);
+        s.solve();
+        EXPECT_EQ(5, s.getDistance(b.getHashableState()));
+    }
+
+}
+
+
+//
+// SolverTest_SolverSymmetry
+//
+TEST(SolverTest, SolverSymmetry) {
+
+    // Storing only canonical states still answers every state.
+    solverOptions options;
+    options.symmetry = true;
+    expectMatchesReference(/*pegs=*/4, /*disks=*/4, /*isBicolor=*/false, options);
+    expectMatchesReference(/*pegs=*/4, /*disks=*/3, /*isBicolor=*/true,  options);
+
+}
+
+
+//
+// SolverTest_SolverFlatStorage
+//
+TEST(SolverTest, SolverFlatStorage) {
+
+    solverOptions options;
+    options.storage = solverOptions::FLAT;
+    expectMatchesReference(/*pegs=*/4, /*disks=*/4, /*isBicolor=*/false, options);
+    expectMatchesReference(/*pegs=*/4, /*disks=*/3, /*isBicolor=*/true,  options);
+
+    // Both write the same solution, though maybe in another order.
+    Solver full(/*pegs=*/3, /*disks=*/3, /*isBicolor=*/true);
+    Solver flat(/*pegs=*/3, /*disks=*/3, /*isBicolor=*/true, options);
+    full.solve();
+    flat.solve();
+    EXPECT_EQ(full.flushSolution().size(), flat.flushSolution().size());
+
+}
+
+
+//
+// SolverTest_SolverDiskStorage
+//
+TEST(SolverTest, SolverDiskStorage) {
+
+    // A tiny buffer forces many runs and merge passes.
+    solverOptions options;
+    options.storage     = solverOptions::DISK;
+    options.disk_path   = testing::TempDir();
+    options.disk_buffer = 7;
+    expectMatchesReference(/*pegs=*/4, /*disks=*/4, /*isBicolor=*/false, options);
+    expectMatchesReference(/*pegs=*/4, /*disks=*/3, /*isBicolor=*/true,  options);
+
+    // Only the table is left behind, one distance per rank.
+    Board     b(/*pegs=*/4, /*disks=*/3, /*isBicolor=*/true);
+    DiskTable table(options.disk_path, options.disk_buffer);
+    EXPECT_TRUE(b.init());
+    EXPECT_TRUE(table.build(b));
+    EXPECT_EQ(table.getNumReached(), b.getNumStates());
+
+    std::ifstream file(table.getTablePath(), std::ios::binary | std::ios::ate);
+    EXPECT_TRUE(file.is_open());
+    EXPECT_EQ((hash_t)file.tellg(), b.getNumStates() * 4);
+    file.close();
+
+    std::ifstream layer(options.disk_path + "/toh_4p_3d_bicolor_" + std::to_string(getpid()) + "_layer0.bin");
+    EXPECT_FALSE(layer.is_open());
+    std::remove(table.getTablePath().c_str());
+
+}
+
+
+//
+// SolverTest_SolverMappedTable
+//
+TEST(SolverTest, SolverMappedTable) {
+
+    // The first solve saves a table, and the next maps it instead of searching.
+    for (bool bicolor : { false, true }) {
+        std::size_t disks = ( bicolor ? 3 : 4 );
+        Board b(/*pegs=*/4, disks, bicolor);
+        EXPECT_TRUE(b.init());
+
+        solverOptions options;
+        options.symmetry   = true;
+        options.table_path = testing::TempDir();
+        std::string file   = options.table_path + "/" + MappedTable::getFileName(4, disks, bicolor);
+        std::remove(file.c_str());
+
+        Solver saved(/*pegs=*/4, disks, bicolor, options);
+        saved.solve();
+
+        MappedTable table;
+        EXPECT_TRUE(table.open(file, b));
+
+        Solver mapped(/*pegs=*/4, disks, bicolor, options);
+        mapped.solve();
+        expectMatchesReference(mapped, /*pegs=*/4, disks, bicolor);
+        EXPECT_EQ(mapped.getBestMove(0), std::make_pair(-1,-1));
+
+        // It holds every state, even when saved from canonical ones.
+        Solver full(/*pegs=*/4, disks, bicolor);
+        full.solve();
+        EXPECT_EQ(full.flushSolution().size(), mapped.flushSolution().size());
+
+        // A table made for other settings is never mapped.
+        Board other(/*pegs=*/4, disks + 1, bicolor);
+        EXPECT_TRUE(other.init());
+        EXPECT_FALSE(table.open(file, other));
+        EXPECT_FALSE(table.isOpen());
+
+        std::remove(file.c_str());
+    }
+
+    // Flat storage answers from the mapped table too.
+    solverOptions options;
+    options.storage    = solverOptions::FLAT;
+    options.table_path = testing::TempDir();
+    std::string file   = options.table_path + "/" + MappedTable::getFileName(3, 5, false);
+
+    Board  b(/*pegs=*/3, /*disks=*/5);
+    Solver saved(/*pegs=*/3, /*disks=*/5, /*isBicolor=*/false, options);
+    Solver mapped(/*pegs=*/3, /*disks=*/5, /*isBicolor=*/false, options);
+    EXPECT_TRUE(b.init());
+    saved.solve();
+    mapped.solve();
+    EXPECT_EQ(31, mapped.getDistance(b.getHashableState()));
+    std::remove(file.c_str());
+
+    // A save that cannot be renamed into place leaves no temporary file.
+    std::string blocked = testing::TempDir() + "/table_blocked";
+    std::filesystem::create_directory(blocked);
+    EXPECT_FALSE(MappedTable::save(blocked, b, [](const BoardSnapshot&, ull& dist) { dist = 0; return true; }));
+    for (const auto& entry : std::filesystem::directory_iterator(testing::TempDir())) {
+        EXPECT_NE(0, entry.path().filename().string().rfind("table_blocked.", 0));
+    }
+    std::filesystem::remove(blocked);
+
+}
+
+
+//
+// SolverTest_SolverSharedTable
+//
+TEST(SolverTest, SolverSharedTable) {
+
+    std::string name = MappedTable::getSharedName(4, 4, false);
+    MappedTable::removeShared(name);
+
+    // Only one of several processes asking at once solves the table.
+    std::atomic<int> solves(0);
+    std::vector<std::thread> workers;
+    for (std::size_t tdx = 0; tdx < 4; ++tdx) {
+        workers.emplace_back([&]() {
+            Board  board(/*pegs=*/4, /*disks=*/4);
+            Solver solver(/*pegs=*/4, /*disks=*/4);
+            board.init();
+
+            MappedTable table;
+            EXPECT_TRUE(table.openShared(name, board,
+                [&]() { solves += 1; solver.solve(); return true; },
+                [&](const BoardSnapshot& state, ull& dist) {
+                    dist = solver.getDistance(state.getHashableState());
+                    return true;
+                }));
+        });
+    }
+    for (std::thread& worker : workers) { worker.join(); }
+    EXPECT_EQ(1, solves.load());
+
+    // A solver attaches to it without solving again.
+    solverOptions options;
+    options.shared = true;
+    expectMatchesReference(/*pegs=*/4, /*disks=*/4, /*isBicolor=*/false, options);
+    EXPECT_EQ(1, solves.load());
+
+    EXPECT_TRUE(MappedTable::removeShared(name));
+    EXPECT_FALSE(MappedTable::removeShared(name));
+
+    // With no table shared yet, a solver solves and shares its own.
+    options.storage = solverOptions::FLAT;
+    name = MappedTable::getSharedName(4, 3, true);
+    MappedTable::removeShared(name);
+    expectMatchesReference(/*pegs=*/4, /*disks=*/3, /*isBicolor=*/true, options);
+
+    Board       b(/*pegs=*/4, /*disks=*/3, /*isBicolor=*/true);
+    MappedTable table;
+    EXPECT_TRUE(b.init());
+    EXPECT_TRUE(table.openShared(name, b, []() { return false; },
+        [](const BoardSnapshot&, ull&) { return false; }));
+    EXPECT_TRUE(MappedTable::removeShared(name));
+
+}
+
+
+//
+// SolverTest_SolverParallel
+//
+TEST(SolverTest, SolverParallel) {
+
+    // Any number of threads finds the same distances as the serial search.
+    for (std::size_t threads : { 1, 2, 5 }) {
+        solverOptions options;
+        options.storage = solverOptions::FLAT;
+        options.threads = threads;
+        expectMatchesReference(/*pegs=*/4, /*disks=*/5, /*isBicolor=*/false, options);
+        expectMatchesReference(/*pegs=*/4, /*disks=*/3, /*isBicolor=*/true,  options);
+    }
+
+}
+
+
+//
+// SolverTest_SolverAStar
+//
+TEST(SolverTest, SolverAStar) {
+
+    // The lower bound never overshoots, and is exact with 3 mono pegs.
+    struct config { std::size_t pegs, disks; bool bicolor; };
+    for (config c : { config{3, 5, false}, config{4, 4, false}, config{3, 3, true}, config{4, 3, true} }) {
+        Board  b(c.pegs, c.disks, c.bicolor);
+        Solver full(c.pegs, c.disks, c.bicolor);
+        EXPECT_TRUE(b.init());
+        full.solve();
+
+        for (hash_t rank = 0; rank < b.getNumStates(); ++rank) {
+            hash_t hash = b.rankToHash(rank);
+            ull    dist = full.getDistance(hash);
+
+            EXPECT_TRUE(b.setFromHashableState(hash));
+            EXPECT_LE(b.getLowerBound(), dist);
+            if (c.pegs == 3 && !c.bicolor) { EXPECT_EQ(dist, b.getLowerBound()); }
+        }
+
+        solverOptions options;
+        options.search = solverOptions::ASTAR;
+        expectMatchesReference(c.pegs, c.disks, c.bicolor, options);
+    }
+
+    // A search that runs out of room answers nothing.
+    solverOptions options;
+    options.search    = solverOptions::ASTAR;
+    options.max_nodes = 10;
+
+    Board  b(/*pegs=*/4, /*disks=*/6);
+    Solver s(/*pegs=*/4, /*disks=*/6, /*isBicolor=*/false, options);
+    EXPECT_TRUE(b.init());
+    EXPECT_EQ(0, s.getDistance(b.getHashableState()));
+    EXPECT_EQ(std::make_pair(-1,-1), s.getBestMove(b.getHashableState()));
+
+}
+
+
+//
+// SolverTest_SolverPatternDatabase
+//
+TEST(SolverTest, SolverPatternDatabase) {
+
+    // A table over every disk is the full solution.
+    struct config { std::size_t pegs, disks; bool bicolor; };
+    for (config c : { config{4, 5, false}, config{3, 3, true} }) {
+        Board           b(c.pegs, c.disks, c.bicolor);
+        Solver          s(c.pegs, c.disks, c.bicolor);
+        PatternDatabase p(c.pegs, c.disks, c.bicolor);
+        EXPECT_TRUE(b.init());
+        EXPECT_FALSE(p.isBuilt());
+        EXPECT_TRUE(p.build());
+        EXPECT_TRUE(p.isBuilt());
+        s.solve();
+
+        std::uint64_t disks = (1ULL << c.disks) - 1;
+        BoardSnapshot state;
+        for (hash_t rank = 0; rank < b.getNumStates(); ++rank) {
+            EXPECT_TRUE(b.getSnapshotFromRank(rank, state));
+            EXPECT_EQ(s.getDistance(b.rankToHash(rank)), p.lookup(state, disks));
+        }
+    }
+
+    // Tables of some of the disks never overshoot.
+    {
+        Board           b(/*pegs=*/3, /*disks=*/4, /*isBicolor=*/true);
+        Solver          s(/*pegs=*/3, /*disks=*/4, /*isBicolor=*/true);
+        PatternDatabase p(/*pegs=*/3, /*disks=*/3, /*isBicolor=*/true);
+        EXPECT_TRUE(b.init());
+        EXPECT_TRUE(p.build());
+        s.solve();
+
+        BoardSnapshot state;
+        for (hash_t rank = 0; rank < b.getNumStates(); ++rank) {
+            EXPECT_TRUE(b.getSnapshotFromRank(rank, state));
+            EXPECT_LE(p.lookup(state, 0xE), s.getDistance(b.rankToHash(rank)));
+            EXPECT_LE(p.lookup(state, 0x7), s.getDistance(b.rankToHash(rank)));
+        }
+    }
+
+    // Tables survive a round trip through a file, and are only loaded for their settings.
+    std::string path = testing::TempDir() + PatternDatabase::getFileName(4, 4, false);
+    PatternDatabase saved(/*pegs=*/4, /*disks=*/4), loaded(/*pegs=*/4, /*disks=*/4), other(/*pegs=*/4, /*disks=*/3);
+    EXPECT_FALSE(saved.save(path));
+    EXPECT_TRUE(saved.build());
+    EXPECT_TRUE(saved.save(path));
+    EXPECT_TRUE(loaded.load(path));
+    EXPECT_FALSE(other.load(path));
+    EXPECT_FALSE(other.isBuilt());
+
+    Board         b(/*pegs=*/4, /*disks=*/4);
+    BoardSnapshot state;
+    EXPECT_TRUE(b.init());
+    for (hash_t rank = 0; rank < b.getNumStates(); ++rank) {
+        EXPECT_TRUE(b.getSnapshotFromRank(rank, state));
+        EXPECT_EQ(saved.lookup(state, 0xF), loaded.lookup(state, 0xF));
+    }
+    std::remove(path.c_str());
+
+}
+
+
+//
+// SolverTest_SolverIDAStar
+//
+TEST(SolverTest, SolverIDAStar) {
+
+    // With the disks split over several tables, or in one table.
+    struct config { std::size_t pegs, disks; bool bicolor; std::size_t pdb_disks; };
+    for (config c : { config{3, 6, false, 3}, config{4, 6, false, 3}, config{5, 5, false, 3},
+                      config{3, 3, true, 0}, config{4, 3, true, 0} }) {
+        solverOptions options;
+        options.search    = solverOptions::IDASTAR;
+        options.pdb_disks = c.pdb_disks;
+        expectMatchesReference(c.pegs, c.disks, c.bicolor, options);
+    }
+
+    // Tables are saved where asked, and found there again.
+    solverOptions options;
+    options.search    = solverOptions::IDASTAR;
+    options.pdb_disks = 3;
+    options.pdb_path  = testing::TempDir();
+
+    std::string path = options.pdb_path + "/" + PatternDatabase::getFileName(4, 3, false);
+    std::remove(path.c_str());
+
+    Solver first(/*pegs=*/4, /*disks=*/6, /*isBicolor=*/false, options);
+    first.solve();
+
+    PatternDatabase p(/*pegs=*/4, /*disks=*/3);
+    EXPECT_TRUE(p.load(path));
+
+    Solver second(/*pegs=*/4, /*disks=*/6, /*isBicolor=*/false, options);
+    Board  b(/*pegs=*/4, /*disks=*/6);
+    EXPECT_TRUE(b.init());
+    EXPECT_EQ(first.getDistance(b.getHashableState()), second.getDistance(b.getHashableState()));
+    std::remove(path.c_str());
+
+}
+
+
+//
+// SolverTest_SolverBidirectional
+//
+TEST(SolverTest, SolverBidirectional) {
+
+    struct config { std::size_t pegs, disks; bool bicolor; };
+    for (config c : { config{3, 5, false}, config{4, 5, false}, config{3, 3, true}, config{4, 3, true} }) {
+        solverOptions options;
+        options.search = solverOptions::BIDIRECTIONAL;
+        expectMatchesReference(c.pegs, c.disks, c.bicolor, options);
+    }
+
+    // A search that runs out of room answers nothing.
+    solverOptions options;
+    options.search    = solverOptions::BIDIRECTIONAL;
+    options.max_nodes = 10;
+
+    Board  b(/*pegs=*/4, /*disks=*/6);
+    Solver s(/*pegs=*/4, /*disks=*/6, /*isBicolor=*/false, options);
+    EXPECT_TRUE(b.init());
+    EXPECT_EQ(0, s.getDistance(b.getHashableState()));
+    EXPECT_EQ(std::make_pair(-1,-1), s.getBestMove(b.getHashableState()));
+
+}
+
+
+//
+// SolverTest_SolverLocalRegion
+//
+TEST(SolverTest, SolverLocalRegion) {
+
+    // A player wandering off the optimal path is answered exactly around
+    // wherever it goes, with and without a budget on each region.
+    struct config { std::size_t pegs, disks; bool bicolor; std::size_t states; };
+    for (config c : { config{4, 6, false, 0}, config{4, 6, false, 5}, config{3, 3, true, 0} }) {
+        Board b(c.pegs, c.disks, c.bicolor);
+        EXPECT_TRUE(b.init());
+
+        solverOptions options;
+        options.search       = solverOptions::BIDIRECTIONAL;
+        options.local_depth  = 2;
+        options.local_states = c.states;
+
+        Solver full(c.pegs, c.disks, c.bicolor);
+        Solver local(c.pegs, c.disks, c.bicolor, options);
+        full.solve();
+        local.solve();
+
+        for (std::size_t step = 0; step < 30; ++step) {
+            hash_t hash = b.getHashableState();
+            ull    dist = full.getDistance(hash);
+            EXPECT_EQ(dist, local.getDistance(hash));
+            if (dist == 0) { break; }
+
+            // Even steps follow the hint, odd steps take the first legal move.
+            pii hint = local.getBestMove(hash);
+            if (step % 2 == 0) {
+                EXPECT_TRUE(b.move(hint.first, hint.second));
+                EXPECT_EQ(dist - 1, full.getDistance(b.getHashableState()));
+                continue;
+            }
+
+            bool moved = false;
+            for (std::size_t mdx = 0; !moved && mdx < c.pegs * c.pegs; ++mdx) {
+                int from = (int)(mdx / c.pegs), to = (int)(mdx % c.pegs);
+                moved = from != to && b.move(from, to);
+            }
+            EXPECT_TRUE(moved);
+        }
+    }
+
+}
+
+
+//
+// SolverTest_SolverAnalytic
+//
+TEST(SolverTest, SolverAnalytic) {
+
+    // Closed form answers cover every mono state, and the goal has no move.
+    solverOptions options;
+    options.search = solverOptions::ANALYTIC;
+    for (std::size_t disks : { 3, 6 }) {
+        Board  b(/*pegs=*/3, disks);
+        Solver analytic(/*pegs=*/3, disks, /*isBicolor=*/false, options);
+        EXPECT_TRUE(b.init());
+        analytic.solve();
+        expectMatchesReference(analytic, /*pegs=*/3, disks, /*isBicolor=*/false);
+        EXPECT_EQ(std::make_pair(-1,-1), analytic.getBestMove(b.getHashableGoal()));
+    }
+
+    // Following the hints solves a large board without solving it up front.
+    Board  b(/*pegs=*/3, /*disks=*/12);
+    Solver s(/*pegs=*/3, /*disks=*/12, /*isBicolor=*/false, options);
+    EXPECT_TRUE(b.init());
+    EXPECT_EQ(4095, s.getDistance(b.getHashableState()));
+    for (ull step = 0; step < 4095; ++step) {
+        pii hint = s.getBestMove(b.getHashableState());
+        EXPECT_TRUE(b.move(hint.first, hint.second));
+    }
+    EXPECT_TRUE(b.isGoal());
+
+    // Bicolor states are answered the same, one size at a time.
+    expectMatchesReference(/*pegs=*/3, /*disks=*/3, /*isBicolor=*/true, options);
+    expectMatchesReference(/*pegs=*/3, /*disks=*/4, /*isBicolor=*/true, options);
+
+    // Boards too large for a full table agree with a search near the goal.
+    solverOptions meet;
+    meet.search = solverOptions::BIDIRECTIONAL;
+
+    Board  bb(/*pegs=*/3, /*disks=*/9, /*isBicolor=*/true);
+    Solver analytic(/*pegs=*/3, /*disks=*/9, /*isBicolor=*/true, options);
+    Solver bidirectional(/*pegs=*/3, /*disks=*/9, /*isBicolor=*/true, meet);
+    EXPECT_TRUE(bb.init());
+    EXPECT_TRUE(bb.setFromHashableState(bb.getHashableGoal()));
+    for (pii step : { pii(0,2), pii(1,2), pii(0,1), pii(2,0), pii(2,0), pii(1,2) }) {
+        EXPECT_TRUE(bb.move(step.first, step.second));
+        hash_t hash = bb.getHashableState();
+        EXPECT_EQ(bidirectional.getDistance(hash), analytic.getDistance(hash));
+    }
+
+    // And from the start, where no size is in place yet.
+    Board start(/*pegs=*/3, /*disks=*/9, /*isBicolor=*/true);
+    EXPECT_TRUE(start.init());
+    ull dist = analytic.getDistance(start.getHashableState());
+    pii hint = analytic.getBestMove(start.getHashableState());
+    EXPECT_EQ(2626, dist);
+    EXPECT_TRUE(start.move(hint.first, hint.second));
+    EXPECT_EQ(dist - 1, analytic.getDistance(start.getHashableState()));
+
+    // Other boards are searched as usual.
+    expectMatchesReference(/*pegs=*/4, /*disks=*/4, /*isBicolor=*/false, options);
+
+}
+
+
+//
+// SolverTest_SolverSolutionSequence
+//
+TEST(SolverTest, SolverSolutionSequence) {
+
+    // Playing the moves in turn solves the board, and every state along 
+    // the way matches the state worked out for that number of moves.
+    for (std::size_t disks : { 3, 4, 7, 10 }) {
+        SolutionSequence seq(disks);
+        Board            b(/*pegs=*/3, disks);
+        Solver           s(/*pegs=*/3, disks);
+        EXPECT_TRUE(b.init());
+        s.solve();
+        EXPECT_EQ(s.getDistance(b.getHashableState()), seq.getLength());
+
+        ull    moves = 0;
+        hash_t rank;
+        for (pii step : seq) {
+            EXPECT_TRUE(seq.getRankAfter(moves, rank));
+            EXPECT_EQ(b.getRankedState(), rank);
+            EXPECT_EQ(step, seq.getMove(moves));
+            EXPECT_TRUE(b.move(step.first, step.second));
+            moves += 1;
+        }
+        EXPECT_EQ(seq.getLength(), moves);
+        EXPECT_TRUE(b.isGoal());
+        EXPECT_TRUE(seq.getRankAfter(moves, rank));
+        EXPECT_EQ(b.getRankedState(), rank);
+    }
+
+    // Moves and states far into long sequences come without walking there.
+    SolutionSequence seq(/*disks=*/40);
+    EXPECT_EQ((1ULL << 40) - 1, seq.getLength());
+    EXPECT_EQ(std::make_pair(0,2), seq.getMove((1ULL << 39) - 1));
+    EXPECT_EQ(std::make_pair(-1,-1), seq.getMove(seq.getLength()));
+    for (std::size_t size = 1; size <= 40; ++size) {
+        EXPECT_EQ(0, seq.getPeg(0, size));
+        EXPECT_EQ(2, seq.getPeg(seq.getLength(), size));
+        EXPECT_EQ(size == 40 ? 2 : 1, seq.getPeg(1ULL << 39, size));
+    }
+    EXPECT_EQ(seq.getMove(seq.getLength() - 5), *seq.begin(seq.getLength() - 5));
+
+    // The longest sequence a ull can count the moves of has 64 disks.
+    SolutionSequence largest(/*disks=*/64);
+    EXPECT_TRUE(largest.isValid());
+    EXPECT_EQ(~0ULL, largest.getLength());
+    EXPECT_EQ(std::make_pair(0,1), largest.getMove(0));
+    EXPECT_EQ(std::make_pair(0,2), largest.getMove((1ULL << 63) - 1));
+    EXPECT_EQ(std::make_pair(-1,-1), largest.getMove(largest.getLength()));
+    for (std::size_t size : { 1, 63, 64 }) {
+        EXPECT_EQ(0, largest.getPeg(0, size));
+        EXPECT_EQ(2, largest.getPeg(largest.getLength(), size));
+        EXPECT_EQ(size == 64 ? 2 : 1, largest.getPeg(1ULL << 63, size));
+    }
+    EXPECT_EQ(-1, largest.getPeg(0, 0));
+    EXPECT_EQ(-1, largest.getPeg(0, 65));
+
+    // Larger sequences are flagged and have no moves.
+    SolutionSequence oversized(/*disks=*/65);
+    hash_t rank;
+    EXPECT_FALSE(oversized.isValid());
+    EXPECT_EQ(0ULL, oversized.getLength());
+    EXPECT_EQ(std::make_pair(-1,-1), oversized.getMove(0));
+    EXPECT_EQ(-1, oversized.getPeg(0, 1));
+    EXPECT_FALSE(oversized.getRankAfter(0, rank));
+    EXPECT_TRUE(oversized.begin() == oversized.end());
+
+}